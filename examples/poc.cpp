@@ -1,32 +1,30 @@
 #include "mbed.h"
 #include "mbed_bme680.h"
 
-I2C i2c(I2C_SDA, I2C_SCL);  // Used inside the BME680 Mbed Lib.
+/*
+ * printf goes to the console, its baud rate is platform.stdio-baud-rate in mbed_app.json.
+ * The float formats need "target.printf_lib": "std" with the default minimal printf.
+ */
 
-Serial pc(USBTX, USBRX);
-
-BME680 bme680(0x77 << 1);
+BME680 bme680(0x77 << 1, I2C_SDA, I2C_SCL);
 
 
 int main() {
-    pc.baud(115200);
-
-
     if (!bme680.begin()) {
-        pc.printf("BME680 Begin failed \r\n");
+        printf("BME680 Begin failed \r\n");
         return 1;
     }
 
     while (true) {
-        pc.printf("-------------------- \r\n");
+        printf("-------------------- \r\n");
 
         if (bme680.performReading()) {
-            pc.printf("BME680 Temperature: %.2f degC \r\n", bme680.getTemperature());
-            pc.printf("BME680 Humidity: %.2f %% \r\n", bme680.getHumidity());
-            pc.printf("BME680 Pressure: %.2f hPa \r\n", bme680.getPressure() / 100.0);
-            pc.printf("BME680 VOC: %0.2f KOhms \r\n", bme680.getGasResistance() / 1000.0);
+            printf("BME680 Temperature: %.2f degC \r\n", bme680.getTemperature());
+            printf("BME680 Humidity: %.2f %% \r\n", bme680.getHumidity());
+            printf("BME680 Pressure: %.2f hPa \r\n", bme680.getPressure() / 100.0);
+            printf("BME680 VOC: %0.2f KOhms \r\n", bme680.getGasResistance() / 1000.0);
         }
 
-        wait(2);
+        ThisThread::sleep_for(2s);
     }
 }
\ No newline at end of file
@@ -1,23 +1,116 @@
 #include "mbed_bme680.h"
 
-BME680::BME680(PinName sda, PinName scl) {
-    BME680(BME680_DEFAULT_ADDRESS, sda, scl);
+#include <new>
+
+/* Logging compiles to nothing unless BME680_DEBUG_MODE is defined, arguments included */
+#ifdef BME680_DEBUG_MODE
+#define BME680_LOG(...) BME680::log(__VA_ARGS__)
+#else
+#define BME680_LOG(...) do {} while (0)
+#endif
+
+/* Library owned setting group, next to the BME680_*_SEL groups of the Bosch API */
+#define BME680_HEATER_PROFILE_SEL UINT16_C(0x100)
+
+/* Every setting group, written again when the sensor state is unknown */
+#define BME680_ALL_SETTINGS_SEL (BME680_OST_SEL | BME680_OSP_SEL | BME680_OSH_SEL | BME680_FILTER_SEL \
+                                 | BME680_GAS_SENSOR_SEL | BME680_HEATER_PROFILE_SEL)
+
+/* ctrl_gas_1 content is not known, e.g. after a reset or a write by the Bosch API */
+#define BME680_CTRL_GAS_UNKNOWN UINT8_C(0xFF)
+
+/* Instrumentation compiles to nothing unless BME680_STATS is defined */
+#ifdef BME680_STATS
+#define BME680_STATS_ADD(field, value) (_stats.field += (value))
+#define BME680_STATS_SET(field, value) (_stats.field = (value))
+#define BME680_STATS_TIME(name) uint32_t name = us_ticker_read()
+#define BME680_STATS_PHASE(phase, since) _stats.phase.add(us_ticker_read() - (since))
+#else
+#define BME680_STATS_ADD(field, value) do {} while (0)
+#define BME680_STATS_SET(field, value) do {} while (0)
+#define BME680_STATS_TIME(name) do {} while (0)
+#define BME680_STATS_PHASE(phase, since) do {} while (0)
+#endif
+
+BME680 *BME680::_instances[BME680_MAX_INSTANCES];
+
+#ifdef BME680_DEBUG_MODE
+CircularBuffer<char, BME680_LOG_BUFFER_SIZE> BME680::_logBuffer;
+#endif
+
+BME680::BME680(PinName sda, PinName scl) : BME680(BME680_DEFAULT_ADDRESS, sda, scl) {
 }
 
 BME680::BME680(uint8_t adr, PinName sda, PinName scl) {
-    i2c(sda, scl);
+    init(adr, new(_i2cBuffer) I2C(sda, scl), true);
+    _sda = sda;
+    _scl = scl;
+}
+
+/**
+ * Creates a sensor on a bus shared with other devices.
+ * @param adr 8 bit I2C address of the sensor
+ * @param i2c Bus the sensor is connected to, must outlive this instance
+ */
+BME680::BME680(uint8_t adr, I2C &i2c) {
+    init(adr, &i2c, false);
+}
+
+BME680::~BME680() {
+    if (_slot < BME680_MAX_INSTANCES)
+        _instances[_slot] = NULL;
+
+    if (_ownsI2c)
+        _i2c->~I2C();
+}
+
+void BME680::init(uint8_t adr, I2C *i2c, bool ownsI2c) {
+    _i2c = i2c;
+    _ownsI2c = ownsI2c;
+    _sda = _scl = NC;
+    _frequency = 0;
+    _sensorLost = false;
     _filterEnabled = _tempEnabled = _humEnabled = _presEnabled = _gasEnabled = false;
+    _dirtySettings = 0;
+    _tphDuration = 0;
+    _direct = false;
+    _measuring = false;
+    _profileCount = _profileStep = 0;
+    _profileValid = 0;
+    _gasSkipped = false;
+    _gasDecimation = 1;
+    _gasCountdown = 0;
+    _gasMeasured = _gasHeld = false;
+    _lastGas = 0;
+    _ctrlGas1 = BME680_CTRL_GAS_UNKNOWN;
     _adr = adr;
+    _sensorID = -1;
+    _latestSeq = 0;
+#ifdef BME680_STATS
+    _triggeredAt = 0;
+    resetStats();
+#endif
+
+    /* Register for the Bosch API callbacks, which only pass dev_id back */
+    _slot = BME680_MAX_INSTANCES;
+    core_util_critical_section_enter();
+    for (uint8_t i = 0; i < BME680_MAX_INSTANCES; i++) {
+        if (_instances[i] == NULL) {
+            _instances[i] = this;
+            _slot = i;
+            break;
+        }
+    }
+    core_util_critical_section_exit();
 }
 
 bool BME680::begin() {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     int8_t result;
 
-    gas_sensor.dev_id = _adr;
-    gas_sensor.intf = BME680_I2C_INTF;
-    gas_sensor.read = &BME680::i2c_read;
-    gas_sensor.write = &BME680::i2c_write;
-    gas_sensor.delay_ms = BME680::delay_msec;
+    if (!setupInterface())
+        return false;
 
     setHumidityOversampling(BME680_OS_2X);
     setPressureOversampling(BME680_OS_4X);
@@ -30,62 +123,526 @@ bool BME680::begin() {
     if (result != BME680_OK)
         return false;
 
+    initialized();
+
+    return true;
+}
+
+/**
+ * Writes a register image built by BME680Config in a single transaction, replacing the setters.
+ * The image's conversion time is used instead of computing it for every reading.
+ * Must be called after BME680#begin, a later setter or BME680#setHeaterProfile overrides the image.
+ * Only the register values and the conversion time are precomputed, the readings take the same runtime path
+ * as with the setters, including the checks of the enable flags and the settings groups.
+ * @param image Register image, BME680Config<...>::image
+ * @return True on success, False on failure
+ */
+bool BME680::applyConfig(const BME680RegisterImage &image) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    if (!_compensation.isLoaded())
+        return false;
+
+    uint8_t regs[] = {
+            BME680_CONF_OS_H_ADDR, BME680_CONF_T_P_MODE_ADDR, BME680_CONF_ODR_FILT_ADDR,
+            BME680_RES_HEAT0_ADDR, BME680_GAS_WAIT0_ADDR, BME680_CONF_ODR_RUN_GAS_NBC_ADDR
+    };
+    uint8_t values[] = {
+            image.ctrlHum, image.ctrlMeas, image.config,
+            _compensation.heaterResistance(image.heaterTemp, gas_sensor.amb_temp), image.gasWait0, image.ctrlGas1
+    };
+    int8_t result = bme680_set_regs(regs, values, sizeof(regs), &gas_sensor);
+
+    BME680_LOG("Set register image, result %d \r\n", result);
+    if (result != BME680_OK) {
+        _ctrlGas1 = BME680_CTRL_GAS_UNKNOWN;
+        return false;
+    }
+
+    /* Keep the Bosch settings and the enable flags in line with the sensor */
+    gas_sensor.tph_sett.os_temp = image.osTemp;
+    gas_sensor.tph_sett.os_pres = image.osPres;
+    gas_sensor.tph_sett.os_hum = image.osHum;
+    gas_sensor.tph_sett.filter = image.filter;
+    gas_sensor.gas_sett.heatr_temp = image.heaterTemp;
+    gas_sensor.gas_sett.heatr_dur = image.heaterDur;
+    gas_sensor.gas_sett.nb_conv = 0;
+    gas_sensor.gas_sett.run_gas = image.heaterDur > 0 ? BME680_ENABLE_GAS_MEAS : BME680_DISABLE_GAS_MEAS;
+
+    _tempEnabled = image.osTemp != BME680_OS_NONE;
+    _presEnabled = image.osPres != BME680_OS_NONE;
+    _humEnabled = image.osHum != BME680_OS_NONE;
+    _filterEnabled = image.filter != BME680_FILTER_SIZE_0;
+    _gasEnabled = image.heaterDur > 0;
+    _profileCount = 0;
+    _lastGas = 0;
+
+    _ctrlGas1 = image.ctrlGas1;
+    _dirtySettings &= ~image.selectMask;
+    _tphDuration = image.tphDuration;
+
+    return true;
+}
+
+/**
+ * Warm boot from a snapshot taken with BME680#exportSnapshot, e.g. after deep sleep.
+ * Only the chip ID is checked on the bus, the soft reset and the calibration read of BME680#begin are skipped.
+ * The snapshot settings are written with the first reading.
+ * @param snapshot Snapshot of this sensor
+ * @return True on success, False if the snapshot is invalid or does not match the sensor
+ */
+bool BME680::begin(const BME680Snapshot &snapshot) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    uint8_t chipId;
+
+    if ((snapshot.version != BME680_SNAPSHOT_VERSION) || (snapshot.address != _adr)
+        || (snapshot.checksum != snapshotChecksum(snapshot)))
+        return false;
+
+    if (!setupInterface())
+        return false;
+
+    if ((bme680_get_regs(BME680_CHIP_ID_ADDR, &chipId, 1, &gas_sensor) != BME680_OK) || (chipId != snapshot.chipId))
+        return false;
+
+    gas_sensor.chip_id = chipId;
+    gas_sensor.amb_temp = snapshot.ambTemp;
+    gas_sensor.calib = snapshot.calib;
+
+    if (!setHumidityOversampling(snapshot.tphSettings.os_hum)
+        || !setPressureOversampling(snapshot.tphSettings.os_pres)
+        || !setTemperatureOversampling(snapshot.tphSettings.os_temp)
+        || !setIIRFilterSize(snapshot.tphSettings.filter))
+        return false;
+
+    setGasHeater(snapshot.gasSettings.run_gas ? snapshot.gasSettings.heatr_temp : 0, snapshot.gasSettings.heatr_dur);
+
+    if ((snapshot.profileCount > 0)
+        && !setHeaterProfile(snapshot.profileTemps, snapshot.profileTimes, snapshot.profileCount))
+        return false;
+
+    initialized();
+
     return true;
 }
 
+/**
+ * Captures the calibration data, the current settings and the heater profile for a later warm boot with BME680#begin(const BME680Snapshot &)
+ * @param snapshot Receives the snapshot
+ * @return True on success, False if the sensor was not initialized
+ */
+bool BME680::exportSnapshot(BME680Snapshot *snapshot) {
+    if (!_compensation.isLoaded())
+        return false;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->version = BME680_SNAPSHOT_VERSION;
+    snapshot->chipId = gas_sensor.chip_id;
+    snapshot->address = _adr;
+    snapshot->ambTemp = gas_sensor.amb_temp;
+    snapshot->calib = gas_sensor.calib;
+    snapshot->tphSettings = gas_sensor.tph_sett;
+    snapshot->gasSettings = gas_sensor.gas_sett;
+    snapshot->gasSettings.run_gas = _gasEnabled ? BME680_ENABLE_GAS_MEAS : BME680_DISABLE_GAS_MEAS;
+    snapshot->profileCount = _profileCount;
+    memcpy(snapshot->profileTemps, _profileTemps, _profileCount * sizeof(_profileTemps[0]));
+    memcpy(snapshot->profileTimes, _profileTimes, _profileCount * sizeof(_profileTimes[0]));
+    snapshot->checksum = snapshotChecksum(*snapshot);
+
+    return true;
+}
+
+#ifdef BME680_USE_KVSTORE
+/**
+ * Stores the snapshot of this sensor in the KVStore, keyed by its I2C address
+ * @return True on success, False on failure
+ */
+bool BME680::saveSnapshot() {
+    BME680Snapshot snapshot;
+    char key[BME680_SNAPSHOT_KEY_SIZE];
+
+    if (!exportSnapshot(&snapshot))
+        return false;
+
+    snapshotKey(key);
+
+    return kv_set(key, &snapshot, sizeof(snapshot), 0) == MBED_SUCCESS;
+}
+
+/**
+ * Warm boot from the snapshot stored with BME680#saveSnapshot
+ * @return True on success, False if there is no matching snapshot
+ */
+bool BME680::beginFromStore() {
+    BME680Snapshot snapshot;
+    char key[BME680_SNAPSHOT_KEY_SIZE];
+    size_t size = 0;
+
+    snapshotKey(key);
+
+    if ((kv_get(key, &snapshot, sizeof(snapshot), &size) != MBED_SUCCESS) || (size != sizeof(snapshot)))
+        return false;
+
+    return begin(snapshot);
+}
+
+/**
+ * KVStore key of the snapshot, one per I2C address so sensors at 0x76 and 0x77 keep separate snapshots
+ */
+void BME680::snapshotKey(char key[BME680_SNAPSHOT_KEY_SIZE]) {
+    snprintf(key, BME680_SNAPSHOT_KEY_SIZE, "/kv/bme680_%02x", _adr >> 1);
+}
+#endif
+
+#ifdef BME680_STATS
+/**
+ * Get the hot path instrumentation collected since the last BME680#resetStats
+ * @return Phase latencies, bus and error counters
+ */
+const BME680Stats &BME680::getStats() {
+    return _stats;
+}
+
+void BME680::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+#endif
+
+/**
+ * Get the chip ID read by BME680#begin
+ * @return Chip ID, -1 before a successful BME680#begin
+ */
+int32_t BME680::getSensorID() {
+    return _sensorID;
+}
+
+bool BME680::setupInterface() {
+    if (_slot >= BME680_MAX_INSTANCES) {
+        BME680_LOG("No free instance slot, increase BME680_MAX_INSTANCES \r\n");
+        return false;
+    }
+
+    gas_sensor.dev_id = _slot;
+    gas_sensor.intf = BME680_I2C_INTF;
+    gas_sensor.read = &BME680::i2c_read;
+    gas_sensor.write = &BME680::i2c_write;
+    gas_sensor.delay_ms = BME680::delay_msec;
+    gas_sensor.amb_temp = 25;
+
+    return true;
+}
+
+void BME680::initialized() {
+    _sensorID = gas_sensor.chip_id;
+    _compensation.load(gas_sensor.calib);
+    _ctrlGas1 = BME680_CTRL_GAS_UNKNOWN;
+    _tphDuration = 0;
+
+    /* The sensor state is unknown after a reset or a warm boot, so every group has to be written again */
+    _dirtySettings = BME680_ALL_SETTINGS_SEL;
+}
+
+/**
+ * FNV-1a hash of the snapshot, without the checksum field
+ */
+uint32_t BME680::snapshotChecksum(const BME680Snapshot &snapshot) {
+    const uint8_t *bytes = (const uint8_t *) &snapshot;
+    uint32_t hash = 2166136261UL;
+
+    for (size_t i = 0; i < offsetof(BME680Snapshot, checksum); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
 /**
  * Performs a full reading of all 4 sensors in the BME680.
  * Assigns the internal BME680#temperature, BME680#pressure, BME680#humidity and BME680#gas_resistance member variables
+ * Blocks the calling thread for the whole measurement, see BME680#startMeasurement for the non-blocking variant.
+ * A failed reading is repeated after BME680#recover, up to BME680_RECOVERY_ATTEMPTS times.
  * @return True on success, False on failure
  */
 bool BME680::performReading(void) {
-    uint8_t set_required_settings = 0;
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    for (uint8_t attempt = 0;; attempt++) {
+        if (measure())
+            return true;
+
+        if ((attempt >= BME680_RECOVERY_ATTEMPTS) || !recover())
+            return false;
+    }
+}
+
+/**
+ * Single blocking reading without recovery, see BME680#performReading
+ * @return True on success, False on failure
+ */
+bool BME680::measure() {
+    uint16_t meas_period = startMeasurement();
+
+    if (meas_period == 0)
+        return false;
+
+    /* Delay till the measurement is ready */
+    delay_msec(meas_period);
+
+    return fetchResult();
+}
+
+/**
+ * Performs back-to-back readings and aggregates them without storing the individual samples.
+ * Settings are applied once with the first reading. The internal data holds the last reading afterwards.
+ * The gas statistics only take readings with a stable gas measurement, not the held values of BME680#setGasDecimation.
+ * @param count Number of readings
+ * @param stats Receives the statistics of the readings, reset first
+ * @return True if all readings succeeded, False on the first failure
+ */
+bool BME680::performBurst(uint16_t count, BME680BurstStats *stats) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    stats->reset();
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (!performReading())
+            return false;
+
+        stats->temperature.add(data.temperature);
+        stats->pressure.add(data.pressure);
+        stats->humidity.add(data.humidity);
+
+        if ((data.status & BME680_GASM_VALID_MSK) && (data.status & BME680_HEAT_STAB_MSK))
+            stats->gasResistance.add(data.gas_resistance);
+    }
+
+    return true;
+}
+
+/**
+ * Triggers a forced mode measurement without waiting for it.
+ * Poll BME680#isMeasurementReady and collect the data with BME680#fetchResult.
+ * @return Measurement duration in milliseconds, 0 on failure
+ */
+uint16_t BME680::startMeasurement() {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    uint16_t meas_period = triggerMeasurement();
+
+    if (meas_period == 0)
+        BME680_STATS_ADD(errors, 1);
+
+    return meas_period;
+}
+
+/**
+ * Pushes the dirty settings and triggers forced mode
+ * @return Measurement duration in milliseconds, 0 on failure
+ */
+uint16_t BME680::triggerMeasurement() {
     int8_t result;
 
+    BME680_STATS_TIME(settingsStart);
+
     /* Select the power mode */
     /* Must be set before writing the sensor configuration */
     gas_sensor.power_mode = BME680_FORCED_MODE;
 
-    /* Set the required sensor settings needed */
-    if (_tempEnabled)
-        set_required_settings |= BME680_OST_SEL;
-    if (_humEnabled)
-        set_required_settings |= BME680_OSH_SEL;
-    if (_presEnabled)
-        set_required_settings |= BME680_OSP_SEL;
-    if (_filterEnabled)
-        set_required_settings |= BME680_FILTER_SEL;
-    if (_gasEnabled)
-        set_required_settings |= BME680_GAS_SENSOR_SEL;
-
-    /* Set the desired sensor configuration */
-    result = bme680_set_sensor_settings(set_required_settings, &gas_sensor);
-    log("Set settings, result %d \r\n", result);
-    if (result != BME680_OK)
-        return false;
+    /* Push only the setting groups that changed since the last reading */
+    uint16_t settings = _dirtySettings & ~BME680_HEATER_PROFILE_SEL;
 
-    /* Set the power mode */
-    result = bme680_set_sensor_mode(&gas_sensor);
-    log("Set power mode, result %d \r\n", result);
-    if (result != BME680_OK)
-        return false;
+    /* The heater profile owns the gas registers while it is active */
+    if (_profileCount > 0)
+        settings &= ~BME680_GAS_SENSOR_SEL;
+
+    if (settings) {
+        result = bme680_set_sensor_settings(settings, &gas_sensor);
+        BME680_LOG("Set settings 0x%X, result %d \r\n", settings, result);
+        if (result != BME680_OK)
+            return 0;
+
+        if (settings & (BME680_RUN_GAS_SEL | BME680_NBCONV_SEL))
+            _ctrlGas1 = BME680_CTRL_GAS_UNKNOWN;
+    }
+
+    bool runGas = gasDue();
+    uint8_t nbConv = 0;
+
+    if (_profileCount > 0) {
+        if ((_dirtySettings & BME680_HEATER_PROFILE_SEL) && !writeHeaterProfile())
+            return 0;
+
+        /* The sequence only advances with readings that measure gas */
+        if (runGas)
+            nbConv = selectHeaterProfileStep();
+    }
+
+    if (!writeGasControl(nbConv, runGas))
+        return 0;
+
+    _dirtySettings = 0;
+
+    BME680_STATS_PHASE(settings, settingsStart);
+    BME680_STATS_TIME(triggerStart);
+
+    /* Set the power mode, the Bosch API also handles a sensor that is not in sleep mode */
+    if (!_direct || !writeForcedMode()) {
+        result = bme680_set_sensor_mode(&gas_sensor);
+        BME680_LOG("Set power mode, result %d \r\n", result);
+        if (result != BME680_OK)
+            return 0;
+    }
+
+    BME680_STATS_PHASE(trigger, triggerStart);
 
     /* Get the total measurement duration so as to sleep or wait till the
      * measurement is complete */
-    uint16_t meas_period;
-    bme680_get_profile_dur(&meas_period, &gas_sensor);
+    uint16_t meas_period = tphDuration() + (runGas ? gas_sensor.gas_sett.heatr_dur : 0);
 
-    /* Delay till the measurement is ready */
-    delay_msec(meas_period);
+    _measReadyAt = Kernel::Clock::now() + std::chrono::milliseconds(meas_period);
+    _measuring = true;
+    _gasMeasured = runGas;
 
-    result = bme680_get_sensor_data(&data, &gas_sensor);
-    log("Get sensor data, result %d \r\n", result);
-    if (result != BME680_OK)
+    if (_gasEnabled && !_gasSkipped)
+        _gasCountdown = runGas ? _gasDecimation - 1 : _gasCountdown - 1;
+
+    BME680_STATS_SET(lastProfileDuration, meas_period);
+#ifdef BME680_STATS
+    _triggeredAt = us_ticker_read();
+#endif
+
+    return meas_period;
+}
+
+/**
+ * Triggers a forced mode measurement and completes it from the given event queue.
+ * The result is fetched on the queue's dispatch thread once the measurement duration elapsed,
+ * so no thread has to block on the sensor.
+ * @param queue Event queue used to fetch the result
+ * @param done Called from the queue with the BME680#fetchResult outcome
+ * @return True if the measurement was started, False on failure
+ */
+bool BME680::startMeasurement(EventQueue &queue, Callback<void(bool)> done) {
+    uint16_t meas_period = startMeasurement();
+
+    if (meas_period == 0)
         return false;
 
+    _measDone = done;
+
+    if (queue.call_in(std::chrono::milliseconds(meas_period), callback(this, &BME680::onMeasurementDone)) == 0) {
+        _measuring = false;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Checks if the measurement started by BME680#startMeasurement had enough time to complete.
+ * Does not access the bus.
+ * @return True if BME680#fetchResult can be called without waiting
+ */
+bool BME680::isMeasurementReady() {
+    return _measuring && Kernel::Clock::now() >= _measReadyAt;
+}
+
+/**
+ * Reads the data of the measurement started by BME680#startMeasurement.
+ * Assigns the internal BME680#temperature, BME680#pressure, BME680#humidity and BME680#gas_resistance member variables
+ * @return True on success, False on failure or if no measurement was started
+ */
+bool BME680::fetchResult() {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    if (!_measuring)
+        return false;
+
+    _measuring = false;
+
+    BME680_STATS_PHASE(wait, _triggeredAt);
+    BME680_STATS_TIME(readStart);
+
+    if (!readMeasurement()) {
+        BME680_STATS_ADD(errors, 1);
+        return false;
+    }
+
+    BME680_STATS_PHASE(read, readStart);
+
     return true;
 }
 
+/**
+ * Reads and compensates the field data into BME680#data
+ * @return True on success, False on failure
+ */
+bool BME680::readMeasurement() {
+    int8_t result;
+
+    /* Fast path: one burst read, compensated with the cached coefficients */
+    uint8_t raw[BME680_FIELD_LENGTH];
+    if (!readRawFieldData(raw) || !_compensation.compensate(raw, &data)) {
+        /* Data not ready yet, let the Bosch API poll for it */
+        result = bme680_get_sensor_data(&data, &gas_sensor);
+        BME680_LOG("Get sensor data, result %d \r\n", result);
+        if (result != BME680_OK)
+            return false;
+    }
+
+    if (_gasMeasured) {
+        bool stable = (data.status & BME680_GASM_VALID_MSK) && (data.status & BME680_HEAT_STAB_MSK);
+
+        _gasHeld = false;
+
+        if (stable)
+            _lastGas = data.gas_resistance;
+
+        if (stable && _profileCount > 0 && data.gas_index < _profileCount) {
+            _profileGas[data.gas_index] = data.gas_resistance;
+            _profileValid |= 1U << data.gas_index;
+        }
+    } else {
+        /* Temperature, pressure and humidity only, keep the last gas measurement.
+         * The gas status bits are left over from the last gas phase, clear them so the held value is not
+         * taken for a new one. */
+        data.status &= (uint8_t) ~(BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK);
+        data.gas_resistance = _lastGas;
+        _gasHeld = _lastGas != 0;
+    }
+
+    publishLatest();
+
+    return true;
+}
+
+/**
+ * Copies the new sample into the buffer readers of BME680#getLatest are not using.
+ * Writers are serialized by BME680#_mutex.
+ */
+void BME680::publishLatest() {
+    uint32_t seq = core_util_atomic_incr_u32(&_latestSeq, 1);  // Odd: write in progress
+    BME680Reading &reading = _latest[(seq >> 1) & 1];
+
+    reading.timestamp = (uint32_t) Kernel::Clock::now().time_since_epoch().count();
+    reading.temperature = data.temperature;
+    reading.pressure = data.pressure;
+    reading.humidity = data.humidity;
+    reading.gasResistance = data.gas_resistance;
+    reading.status = data.status;
+
+    core_util_atomic_incr_u32(&_latestSeq, 1);
+}
+
+void BME680::onMeasurementDone() {
+    bool success = fetchResult();
+
+    if (_measDone)
+        _measDone(success);
+}
+
 bool BME680::isGasHeatingSetupStable() {
     if (data.status & BME680_HEAT_STAB_MSK) {
         return true;
@@ -94,22 +651,78 @@ bool BME680::isGasHeatingSetupStable() {
     return false;
 }
 
+/**
+ * Tells if the last reading ran the gas phase. Readings left out by BME680#skipGasMeasurement or
+ * BME680#setGasDecimation only measure temperature, pressure and humidity.
+ * @return True if the last reading measured the gas resistance
+ */
+bool BME680::isGasMeasured() {
+    return _gasMeasured;
+}
+
+/**
+ * Get last read temperature without floating point conversion
+ * @return Temperature in centi degree celsius
+ */
 int16_t BME680::getRawTemperature() {
     return data.temperature;
 }
 
+/**
+ * Get last read pressure without floating point conversion
+ * @return Pressure in Pascal
+ */
 uint32_t BME680::getRawPressure() {
     return data.pressure;
 }
 
+/**
+ * Get last read humidity without floating point conversion
+ * @return Humidity in milli % relative humidity
+ */
 uint32_t BME680::getRawHumidity() {
     return data.humidity;
 }
 
+/**
+ * Get last read gas resistance, regardless of the heater stability
+ * @return Gas resistance in Ohms
+ */
 uint32_t BME680::getRawGasResistance() {
     return data.gas_resistance;
 }
 
+/**
+ * Get the complete result of the last reading, including the status bits
+ * @return Last compensated field data
+ */
+const struct bme680_field_data &BME680::getFieldData() {
+    return data;
+}
+
+/**
+ * Get a consistent copy of the latest sample, callable from any thread while another one is measuring.
+ * Does not take a lock: the writer alternates between two buffers, a copy is only retried if two
+ * samples were published while it was taken.
+ * @param reading Receives the latest sample
+ * @return True on success, False if no sample was read yet
+ */
+bool BME680::getLatest(BME680Reading *reading) {
+    uint32_t seq, published;
+
+    do {
+        seq = core_util_atomic_load_u32(&_latestSeq);
+        published = seq >> 1;
+
+        if (published == 0)
+            return false;
+
+        *reading = _latest[(published - 1) & 1];
+    } while (core_util_atomic_load_u32(&_latestSeq) - (seq & ~1U) >= 3);
+
+    return true;
+}
+
 /**
  * Get last read temperature
  * @return Temperature in degree celsius
@@ -118,8 +731,8 @@ float BME680::getTemperature() {
     float temperature = NAN;
 
     if (_tempEnabled) {
-        temperature = data.temperature / 100.0;
-        log("Temperature Raw Data %d \r\n", temperature);
+        temperature = data.temperature * 0.01f;
+        BME680_LOG("Temperature Raw Data %d \r\n", data.temperature);
     }
 
     return temperature;
@@ -133,8 +746,8 @@ float BME680::getHumidity() {
     float humidity = NAN;
 
     if (_humEnabled) {
-        humidity = data.humidity / 1000.0;
-        log("Humidity Raw Data %d \r\n", humidity);
+        humidity = data.humidity * 0.001f;
+        BME680_LOG("Humidity Raw Data %u \r\n", data.humidity);
     }
 
     return humidity;
@@ -151,7 +764,7 @@ float BME680::getPressure() {
 
     if (_presEnabled) {
         pressure = data.pressure;
-        log("Pressure Raw Data %d \r\n", pressure);
+        BME680_LOG("Pressure Raw Data %u \r\n", data.pressure);
     }
 
     return pressure;
@@ -165,11 +778,11 @@ float BME680::getGasResistance() {
     float gas_resistance = 0;
 
     if (_gasEnabled) {
-        if (this->isGasHeatingSetupStable()) {
+        if (this->isGasHeatingSetupStable() || _gasHeld) {
             gas_resistance = data.gas_resistance;
-            log("Gas Resistance Raw Data %d \r\n", gas_resistance);
+            BME680_LOG("Gas Resistance Raw Data %u \r\n", data.gas_resistance);
         } else {
-            log("Gas reading unstable \r\n");
+            BME680_LOG("Gas reading unstable \r\n");
         }
     }
 
@@ -183,8 +796,13 @@ float BME680::getGasResistance() {
  * @return True on success, False on failure
  */
 bool BME680::setGasHeater(uint16_t heaterTemp, uint16_t heaterTime) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     gas_sensor.gas_sett.heatr_temp = heaterTemp;
     gas_sensor.gas_sett.heatr_dur = heaterTime;
+    gas_sensor.gas_sett.nb_conv = 0;
+    _profileCount = 0;
+    _lastGas = 0;
 
     if ((heaterTemp == 0) || (heaterTime == 0)) {
         // disabled!
@@ -194,9 +812,240 @@ bool BME680::setGasHeater(uint16_t heaterTemp, uint16_t heaterTime) {
         gas_sensor.gas_sett.run_gas = BME680_ENABLE_GAS_MEAS;
         _gasEnabled = true;
     }
+
+    _dirtySettings |= BME680_GAS_SENSOR_SEL;
+    return true;
+}
+
+/**
+ * Enable gas reading with a sequence of heater set-points.
+ * The table is programmed into the sensor once, consecutive measurements then cycle through the steps.
+ * BME680#getHeaterProfileStep tells which step the last reading used. Calling BME680#setGasHeater ends the sequence.
+ * @param heaterTemps Desired temperatures in degrees Centigrade, one per step
+ * @param heaterTimes Times to keep the heater on in milliseconds, one per step
+ * @param count Number of steps, 1 to BME680_HEATER_PROFILE_LEN
+ * @return True on success, False on failure
+ */
+bool BME680::setHeaterProfile(const uint16_t *heaterTemps, const uint16_t *heaterTimes, uint8_t count) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    if ((count == 0) || (count > BME680_HEATER_PROFILE_LEN)) return false;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if ((heaterTemps[i] == 0) || (heaterTimes[i] == 0)) return false;
+
+        _profileTemps[i] = heaterTemps[i];
+        _profileTimes[i] = heaterTimes[i];
+    }
+
+    _profileCount = count;
+    _profileStep = 0;
+    _profileValid = 0;
+    _gasEnabled = true;
+    _lastGas = 0;
+
+    _dirtySettings |= BME680_HEATER_PROFILE_SEL;
+    return true;
+}
+
+/**
+ * Get the heater profile step used by the last reading
+ * @return Step index, 0 when no heater profile is active
+ */
+uint8_t BME680::getHeaterProfileStep() {
+    return data.gas_index;
+}
+
+/**
+ * Get the last stable gas resistance measured with a heater profile step
+ * @param step Step index
+ * @param gasResistance Receives the gas resistance in Ohms
+ * @return True if the step has a stable reading, False otherwise
+ */
+bool BME680::getHeaterProfileResult(uint8_t step, uint32_t *gasResistance) {
+    if ((step >= _profileCount) || !(_profileValid & (1U << step))) return false;
+
+    *gasResistance = _profileGas[step];
+    return true;
+}
+
+/**
+ * Programs all heater set-points of the profile into res_heat_x and gas_wait_x
+ * @return True on success, False on failure
+ */
+bool BME680::writeHeaterProfile() {
+    uint8_t regs[BME680_HEATER_PROFILE_LEN], values[BME680_HEATER_PROFILE_LEN];
+    int8_t result;
+
+    for (uint8_t i = 0; i < _profileCount; i++) {
+        regs[i] = BME680_RES_HEAT0_ADDR + i;
+        values[i] = _compensation.heaterResistance(_profileTemps[i], gas_sensor.amb_temp);
+    }
+
+    result = bme680_set_regs(regs, values, _profileCount, &gas_sensor);
+    BME680_LOG("Set heater resistances, result %d \r\n", result);
+    if (result != BME680_OK)
+        return false;
+
+    for (uint8_t i = 0; i < _profileCount; i++) {
+        regs[i] = BME680_GAS_WAIT0_ADDR + i;
+        values[i] = BME680Compensation::heaterDuration(_profileTimes[i]);
+    }
+
+    result = bme680_set_regs(regs, values, _profileCount, &gas_sensor);
+    BME680_LOG("Set heater durations, result %d \r\n", result);
+    if (result != BME680_OK)
+        return false;
+
+    return true;
+}
+
+/**
+ * Selects the next heater profile step for the upcoming measurement
+ * @return Heater set-point index to use
+ */
+uint8_t BME680::selectHeaterProfileStep() {
+    uint8_t step = _profileStep;
+
+    /* Keep the Bosch settings in line, bme680_get_profile_dur() uses them */
+    gas_sensor.gas_sett.heatr_temp = _profileTemps[step];
+    gas_sensor.gas_sett.heatr_dur = _profileTimes[step];
+
+    _profileStep = (step + 1) % _profileCount;
+
+    return step;
+}
+
+/**
+ * Writes run_gas and nb_conv of ctrl_gas_1, only if they differ from the last written value
+ * @param nbConv Heater set-point index to use
+ * @param runGas True to measure gas with the next reading
+ * @return True on success, False on failure
+ */
+bool BME680::writeGasControl(uint8_t nbConv, bool runGas) {
+    uint8_t value = (runGas ? BME680_RUN_GAS_MSK : 0) | (nbConv & BME680_NBCONV_MSK);
+
+    if (value != _ctrlGas1) {
+        uint8_t reg = BME680_CONF_ODR_RUN_GAS_NBC_ADDR;
+        int8_t result = bme680_set_regs(&reg, &value, 1, &gas_sensor);
+
+        BME680_LOG("Set gas control 0x%X, result %d \r\n", value, result);
+        if (result != BME680_OK)
+            return false;
+
+        _ctrlGas1 = value;
+    }
+
+    gas_sensor.gas_sett.run_gas = runGas ? BME680_ENABLE_GAS_MEAS : BME680_DISABLE_GAS_MEAS;
+    gas_sensor.gas_sett.nb_conv = nbConv;
+
+    return true;
+}
+
+/**
+ * Skips the gas measurement of the following readings, the heater configuration is kept.
+ * Readings then only take the temperature, pressure and humidity conversion time.
+ * @param skip True to measure temperature, pressure and humidity only
+ */
+void BME680::skipGasMeasurement(bool skip) {
+    _gasSkipped = skip;
+}
+
+/**
+ * Runs the gas measurement only with every n-th reading, the readings in between only measure temperature,
+ * pressure and humidity and take accordingly less time. Only ctrl_gas_1 is rewritten when the phase toggles.
+ * The in between readings keep the gas resistance of the last gas measurement, with the gas status bits cleared.
+ * @param decimation Readings per gas measurement, 1 measures gas with every reading
+ * @return True on success, False if decimation is 0
+ */
+bool BME680::setGasDecimation(uint16_t decimation) {
+    if (decimation == 0) return false;
+
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    _gasDecimation = decimation;
+    _gasCountdown = 0;
     return true;
 }
 
+/**
+ * Triggers the following readings with one ctrl_meas write instead of the mode polling of the Bosch API.
+ * Together with the cached settings and the burst read of the field data a reading then takes two bus
+ * transactions. A failed write falls back to the Bosch API, as does a read without new data.
+ * The sensor must be in sleep mode when triggered, i.e. the previous measurement must have completed.
+ * @param direct True to use the direct trigger
+ */
+void BME680::setDirectMode(bool direct) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    _direct = direct;
+}
+
+/**
+ * Sets the bus frequency. An owned bus keeps it across the bus clears of BME680#recover,
+ * on a shared bus it applies to all devices and is not restored, see BME680Bus#frequency.
+ * @param hz Bus frequency in Hz
+ */
+void BME680::frequency(int hz) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    _frequency = hz;
+    _i2c->frequency(hz);
+}
+
+/**
+ * Writes ctrl_meas with the oversampling settings and forced mode
+ * @return True on success, False on failure
+ */
+bool BME680::writeForcedMode() {
+    uint8_t reg = BME680_CONF_T_P_MODE_ADDR;
+    uint8_t value = (uint8_t) ((gas_sensor.tph_sett.os_temp << 5) | (gas_sensor.tph_sett.os_pres << 2)
+                               | BME680_FORCED_MODE);
+    int8_t result = bme680_set_regs(&reg, &value, 1, &gas_sensor);
+
+    BME680_LOG("Set forced mode 0x%X, result %d \r\n", value, result);
+    return result == BME680_OK;
+}
+
+/**
+ * Get the temperature, pressure and humidity conversion time, computed once per settings change
+ * @return Conversion time in milliseconds
+ */
+uint16_t BME680::tphDuration() {
+    if (_tphDuration == 0) {
+        uint8_t runGas = gas_sensor.gas_sett.run_gas;
+
+        gas_sensor.gas_sett.run_gas = BME680_DISABLE_GAS_MEAS;
+        bme680_get_profile_dur(&_tphDuration, &gas_sensor);
+        gas_sensor.gas_sett.run_gas = runGas;
+    }
+
+    return _tphDuration;
+}
+
+/**
+ * @return True if the next reading measures gas
+ */
+bool BME680::gasDue() {
+    return _gasEnabled && !_gasSkipped && (_gasCountdown == 0);
+}
+
+/**
+ * Get the duration of the next measurement with the current settings
+ * @return Measurement duration in milliseconds
+ */
+uint16_t BME680::getProfileDuration() {
+    return tphDuration() + (gasDue() ? gas_sensor.gas_sett.heatr_dur : 0);
+}
+
+/**
+ * Get the heating time of the gas measurement, with a heater profile the one of the current step
+ * @return Heating time in milliseconds, 0 if gas reading is disabled
+ */
+uint16_t BME680::getHeaterDuration() {
+    return _gasEnabled ? gas_sensor.gas_sett.heatr_dur : 0;
+}
+
 /**
  * Setter for Temperature oversampling
  * @param oversample Oversampling setting, can be BME680_OS_NONE (turn off Temperature reading),
@@ -204,6 +1053,8 @@ bool BME680::setGasHeater(uint16_t heaterTemp, uint16_t heaterTime) {
  * @return True on success, False on failure
  */
 bool BME680::setTemperatureOversampling(uint8_t oversample) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     if (oversample > BME680_OS_16X) return false;
 
     gas_sensor.tph_sett.os_temp = oversample;
@@ -213,6 +1064,8 @@ bool BME680::setTemperatureOversampling(uint8_t oversample) {
     else
         _tempEnabled = true;
 
+    _dirtySettings |= BME680_OST_SEL;
+    _tphDuration = 0;
     return true;
 }
 
@@ -223,6 +1076,8 @@ bool BME680::setTemperatureOversampling(uint8_t oversample) {
  * @return True on success, False on failure
  */
 bool BME680::setHumidityOversampling(uint8_t oversample) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     if (oversample > BME680_OS_16X) return false;
 
     gas_sensor.tph_sett.os_hum = oversample;
@@ -232,6 +1087,8 @@ bool BME680::setHumidityOversampling(uint8_t oversample) {
     else
         _humEnabled = true;
 
+    _dirtySettings |= BME680_OSH_SEL;
+    _tphDuration = 0;
     return true;
 }
 
@@ -242,6 +1099,8 @@ bool BME680::setHumidityOversampling(uint8_t oversample) {
  * @return True on success, False on failure
  */
 bool BME680::setPressureOversampling(uint8_t oversample) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     if (oversample > BME680_OS_16X) return false;
 
     gas_sensor.tph_sett.os_pres = oversample;
@@ -251,6 +1110,8 @@ bool BME680::setPressureOversampling(uint8_t oversample) {
     else
         _presEnabled = true;
 
+    _dirtySettings |= BME680_OSP_SEL;
+    _tphDuration = 0;
     return true;
 }
 
@@ -262,6 +1123,8 @@ bool BME680::setPressureOversampling(uint8_t oversample) {
  * @return True on success, False on failure
  */
 bool BME680::setIIRFilterSize(uint8_t filter_seize) {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
     if (filter_seize > BME680_FILTER_SIZE_127) return false;
 
     gas_sensor.tph_sett.filter = filter_seize;
@@ -271,77 +1134,357 @@ bool BME680::setIIRFilterSize(uint8_t filter_seize) {
     else
         _filterEnabled = true;
 
+    _dirtySettings |= BME680_FILTER_SEL;
+    return true;
+}
+
+
+/**
+ * Reads the complete field data block (status, pressure, temperature, humidity and gas ADC values)
+ * in a single bus transaction, without any compensation.
+ * @param buffer Receives BME680_FIELD_LENGTH bytes starting at BME680_FIELD0_ADDR
+ * @return True on success, False on failure
+ */
+bool BME680::readRawFieldData(uint8_t buffer[BME680_FIELD_LENGTH]) {
+    return busRead(BME680_FIELD0_ADDR, buffer, BME680_FIELD_LENGTH) == 0;
+}
+
+/**
+ * Runs one I2C transaction: writes tx and, if rx is given, reads rx after a repeated start.
+ * Uses I2C::transfer() when BME680_USE_I2C_ASYNCH is enabled so the calling thread sleeps until
+ * the transfer completes, otherwise the blocking I2C calls.
+ * A failed transaction is repeated up to BME680_I2C_RETRIES times with an increasing delay.
+ * @param tx Data to write
+ * @param txLen Number of bytes to write
+ * @param rx Read data buffer, NULL for a write only transaction
+ * @param rxLen Number of bytes to read
+ * @return 0 on success, non-zero for failure
+ */
+int8_t BME680::transfer(const char *tx, int txLen, char *rx, int rxLen) {
+    int8_t result;
+
+    for (uint8_t attempt = 0;; attempt++) {
+        result = busTransaction(tx, txLen, rx, rxLen);
+
+        BME680_STATS_ADD(transactions, 1);
+        BME680_STATS_ADD(bytesWritten, txLen);
+
+        if (rx != NULL)
+            BME680_STATS_ADD(bytesRead, rxLen);
+
+        if (result == 0)
+            break;
+
+        BME680_STATS_ADD(nacks, 1);
+
+        if (attempt >= BME680_I2C_RETRIES)
+            break;
+
+        /* Register reads and writes can be repeated, back off so a disturbance can settle */
+        BME680_STATS_ADD(retries, 1);
+        wait_us(BME680_I2C_RETRY_DELAY_US << attempt);
+    }
+
+    return result;
+}
+
+/**
+ * Recovers from bus or sensor failures, called by BME680#performReading after a failed reading.
+ * The settings are written again with the next reading, since a glitch that failed the reading may have
+ * reset the sensor. If the sensor still answers with its chip ID nothing else is done. Otherwise an owned
+ * bus is cleared and, once the sensor answers again, it is reinitialized.
+ * @return True if the sensor is ready for the next reading, False if it does not answer
+ */
+bool BME680::recover() {
+    ScopedLock<PlatformMutex> lock(_mutex);
+
+    if (!_compensation.isLoaded())
+        return false;
+
+    BME680_STATS_ADD(recoveries, 1);
+    _measuring = false;
+    _ctrlGas1 = BME680_CTRL_GAS_UNKNOWN;
+    _dirtySettings |= BME680_ALL_SETTINGS_SEL;
+
+    if (!_sensorLost && readChipId())
+        return true;
+
+    if (resetBus())
+        BME680_STATS_ADD(busClears, 1);
+
+    if (!readChipId() || (bme680_init(&gas_sensor) != BME680_OK)) {
+        BME680_LOG("Sensor lost \r\n");
+        _sensorLost = true;
+        return false;
+    }
+
+    initialized();
+    _sensorLost = false;
+    BME680_STATS_ADD(reinits, 1);
+
     return true;
 }
 
+/**
+ * Frees a bus held low by a device that was interrupted in the middle of a transfer:
+ * clocks SCL until SDA is released, at most 9 times, and ends with a stop condition.
+ * The pins must not be in use by an I2C object.
+ * @param sda I2C data pin
+ * @param scl I2C clock pin
+ * @return True if SDA is released, False if it is still held low
+ */
+bool BME680::clearBus(PinName sda, PinName scl) {
+    /* A line is released by switching it to input, the bus pull-ups drive it high */
+    DigitalInOut sdaPin(sda, PIN_INPUT, PullNone, 1);
+    DigitalInOut sclPin(scl, PIN_INPUT, PullNone, 1);
+
+    for (uint8_t i = 0; i < 9 && sdaPin.read() == 0; i++) {
+        sclPin.write(0);
+        sclPin.output();
+        wait_us(5);
+        sclPin.input();
+        wait_us(5);
+    }
+
+    /* Stop condition, SDA rises while SCL is high */
+    sclPin.write(0);
+    sclPin.output();
+    sdaPin.write(0);
+    sdaPin.output();
+    wait_us(5);
+    sclPin.input();
+    wait_us(5);
+    sdaPin.input();
+    wait_us(5);
+
+    return sdaPin.read() == 1;
+}
+
+bool BME680::readChipId() {
+    uint8_t chipId;
+
+    return (bme680_get_regs(BME680_CHIP_ID_ADDR, &chipId, 1, &gas_sensor) == BME680_OK) && (chipId == BME680_CHIP_ID);
+}
+
+/**
+ * Clears the bus if this instance owns it, the I2C object is constructed again afterwards
+ * @return True if the bus was cleared
+ */
+bool BME680::resetBus() {
+    if (!_ownsI2c || (_sda == NC) || (_scl == NC))
+        return false;
+
+    _i2c->~I2C();
+    clearBus(_sda, _scl);
+    _i2c = new(_i2cBuffer) I2C(_sda, _scl);
+
+    if (_frequency != 0)
+        _i2c->frequency(_frequency);
+
+    return true;
+}
+
+/**
+ * Single I2C transaction without instrumentation, see BME680#transfer
+ */
+int8_t BME680::busTransaction(const char *tx, int txLen, char *rx, int rxLen) {
+    DeepSleepLock deepSleepLock;  // The I2C peripheral is not clocked in deep sleep
+
+#if BME680_USE_I2C_ASYNCH
+    /* A callback arriving after the timeout of an earlier transfer must not complete this one */
+    while (_transferDone.try_acquire()) {
+    }
+
+    _transferEvent = 0;
+
+    if (_i2c->transfer(_adr, tx, txLen, rx, rxLen, callback(this, &BME680::onTransferDone), I2C_EVENT_ALL) != 0)
+        return BME680_E_COM_FAIL;
+
+    if (!_transferDone.try_acquire_for(std::chrono::milliseconds(BME680_I2C_TIMEOUT_MS))) {
+        _i2c->abort_transfer();
+        BME680_LOG("[Transfer timeout] ");
+        return BME680_E_COM_FAIL;
+    }
+
+    if ((_transferEvent & BME680_I2C_EVENT_ERRORS) || !(_transferEvent & I2C_EVENT_TRANSFER_COMPLETE))
+        return BME680_E_COM_FAIL;
+
+    return 0;
+#else
+    int result;
+
+    if (rx == NULL)
+        return _i2c->write(_adr, tx, txLen);
+
+    result = _i2c->write(_adr, tx, txLen, true);
+    BME680_LOG("[W: %d] ", result);
+
+    if (result != 0) {
+        _i2c->stop();
+        return result;
+    }
+
+    return _i2c->read(_adr, rx, rxLen);
+#endif
+}
+
+#if BME680_USE_I2C_ASYNCH
+/**
+ * I2C::transfer() completion, called from interrupt context
+ */
+void BME680::onTransferDone(int event) {
+    _transferEvent = event;
+    _transferDone.release();
+}
+#endif
 
 /**
  * Reads 8 bit values over I2C
- * @param dev_id Device ID (8 bits I2C address)
+ * The register address write and the data read are combined with a repeated start.
  * @param reg_addr Register address to read from
  * @param reg_data Read data buffer
  * @param len Number of bytes to read
  * @return 0 on success, non-zero for failure
  */
-int8_t BME680::i2c_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
+int8_t BME680::busRead(uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
     int8_t result;
     char data[1];
 
     data[0] = (char) reg_addr;
 
-    log("[0x%X] I2C $%X => ", dev_id >> 1, data[0]);
+    BME680_LOG("[0x%X] I2C $%X => ", _adr >> 1, data[0]);
+
+    /* Keep other threads off the bus between the repeated start and the read */
+    _i2c->lock();
 
-    result = i2c.write(dev_id, data, 1);
-    log("[W: %d] ", result);
+    result = transfer(data, 1, (char *) reg_data, len);
 
-    result = i2c.read(dev_id, (char *) reg_data, len);
+    _i2c->unlock();
 
-    for (uint8_t i = 0; i < len; i++) log("0x%X ", reg_data[i]);
+#ifdef BME680_DEBUG_MODE
+    for (uint8_t i = 0; i < len; i++) BME680_LOG("0x%X ", reg_data[i]);
+#endif
 
-    log("[R: %d, L: %d] \r\n", result, len);
+    BME680_LOG("[R: %d, L: %d] \r\n", result, len);
 
     return result;
 }
 
 /**
  * Writes 8 bit values over I2C
- * @param dev_id Device ID (8 bits I2C address)
+ * The Bosch API sends register/value pairs (reg_addr, reg_data[0], reg_data[1], reg_data[2], ...).
+ * Blocks larger than BME680_WRITE_BUFFER_SIZE are split on pair boundaries.
  * @param reg_addr Register address to write to
  * @param reg_data Write data buffer
  * @param len Number of bytes to write
  * @return 0 on success, non-zero for failure
  */
-int8_t BME680::i2c_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
-    int8_t result;
-    char data[len + 1];
+int8_t BME680::busWrite(uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
+    static_assert(BME680_WRITE_BUFFER_SIZE >= 2 && BME680_WRITE_BUFFER_SIZE % 2 == 0,
+                  "BME680_WRITE_BUFFER_SIZE must hold whole register/value pairs");
 
-    data[0] = (char) reg_addr;
+    int8_t result = 0;
+    uint32_t total = (uint32_t) len + 1;
 
-    for (uint8_t i = 1; i < len + 1; i++) {
-        data[i] = (char) reg_data[i - 1];
-    }
+    /* _writeBuffer is shared by every thread using this instance */
+    _i2c->lock();
+
+    for (uint32_t start = 0; start < total && result == 0; start += BME680_WRITE_BUFFER_SIZE) {
+        uint32_t chunk = total - start;
+
+        if (chunk > BME680_WRITE_BUFFER_SIZE)
+            chunk = BME680_WRITE_BUFFER_SIZE;
+
+        for (uint32_t i = 0; i < chunk; i++) {
+            uint32_t pos = start + i;
+            _writeBuffer[i] = (char) (pos == 0 ? reg_addr : reg_data[pos - 1]);
+        }
 
-    log("[0x%X] I2C $%X <= ", dev_id >> 1, data[0]);
+        BME680_LOG("[0x%X] I2C $%X <= ", _adr >> 1, _writeBuffer[0]);
 
-    result = i2c.write(dev_id, data, len + 1);
+        result = transfer(_writeBuffer, chunk, NULL, 0);
 
-    for (uint8_t i = 1; i < len + 1; i++) log("0x%X ", data[i]);
+#ifdef BME680_DEBUG_MODE
+        for (uint32_t i = 1; i < chunk; i++) BME680_LOG("0x%X ", _writeBuffer[i]);
+#endif
+
+        BME680_LOG("[W: %d, L: %d] \r\n", result, chunk - 1);
+    }
 
-    log("[W: %d, L: %d] \r\n", result, len);
+    _i2c->unlock();
 
     return result;
 }
 
+/**
+ * Bosch API read callback
+ * @param dev_id Instance slot set in BME680#begin
+ * @param reg_addr Register address to read from
+ * @param reg_data Read data buffer
+ * @param len Number of bytes to read
+ * @return 0 on success, non-zero for failure
+ */
+int8_t BME680::i2c_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
+    if (dev_id >= BME680_MAX_INSTANCES || _instances[dev_id] == NULL)
+        return BME680_E_COM_FAIL;
+
+    return _instances[dev_id]->busRead(reg_addr, reg_data, len);
+}
+
+/**
+ * Bosch API write callback
+ * @param dev_id Instance slot set in BME680#begin
+ * @param reg_addr Register address to write to
+ * @param reg_data Write data buffer
+ * @param len Number of bytes to write
+ * @return 0 on success, non-zero for failure
+ */
+int8_t BME680::i2c_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len) {
+    if (dev_id >= BME680_MAX_INSTANCES || _instances[dev_id] == NULL)
+        return BME680_E_COM_FAIL;
+
+    return _instances[dev_id]->busWrite(reg_addr, reg_data, len);
+}
+
 void BME680::delay_msec(uint32_t ms) {
-    log(" * wait %d ms ... \r\n", ms);
+    BME680_LOG(" * wait %d ms ... \r\n", ms);
     ThisThread::sleep_for(std::chrono::milliseconds(ms));
 }
 
-void BME680::log(const char *format, ...) {
 #ifdef BME680_DEBUG_MODE
+/**
+ * Formats a log message into the log buffer, never blocks on the output.
+ * The oldest characters are overwritten when the buffer is full.
+ */
+void BME680::log(const char *format, ...) {
+    char line[BME680_LOG_LINE_SIZE];
     va_list args;
+    int len;
+
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    len = vsnprintf(line, sizeof(line), format, args);
     va_end(args);
+
+    if (len < 0)
+        return;
+
+    if (len >= (int) sizeof(line))
+        len = sizeof(line) - 1;
+
+    for (int i = 0; i < len; i++)
+        _logBuffer.push(line[i]);
+}
+#endif
+
+/**
+ * Writes the buffered debug log to stderr.
+ * Call it from a low priority context, outside of sensor transactions. Does nothing without BME680_DEBUG_MODE.
+ */
+void BME680::flushLog() {
+#ifdef BME680_DEBUG_MODE
+    char c;
+
+    while (_logBuffer.pop(c))
+        fputc(c, stderr);
 #endif
 }
@@ -3,23 +3,142 @@
 
 #include "bme680.h"
 #include "mbed.h"
+#include "mbed_bme680_compensation.h"
+#include "mbed_bme680_config.h"
+#include "mbed_bme680_running_stats.h"
+#include "mbed_bme680_stats.h"
 
 #define BME680_DEFAULT_ADDRESS (0x77 << 1)  // The default I2C address (shifted for MBed 8 bit address)
 //#define BME680_DEBUG_MODE  // Use this for enhance debug logs for I2C and more.
+//#define BME680_STATS  // Use this to collect per phase latencies and I2C counters, see BME680#getStats.
+//#define BME680_USE_KVSTORE  // Use this to store warm boot snapshots in the global KVStore.
+//#define BME680_I2C_ASYNCH  // Use I2C::transfer() on targets with DEVICE_I2C_ASYNCH, the calling thread sleeps during transfers.
+
+#ifdef BME680_USE_KVSTORE
+#include "kvstore_global_api.h"
+#endif
+
+#if defined(BME680_I2C_ASYNCH) && DEVICE_I2C_ASYNCH
+#define BME680_USE_I2C_ASYNCH 1
+#define BME680_I2C_EVENT_ERRORS (I2C_EVENT_ERROR | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)
+#else
+#define BME680_USE_I2C_ASYNCH 0
+#endif
+
+#ifndef BME680_I2C_TIMEOUT_MS
+#define BME680_I2C_TIMEOUT_MS 100  // Upper bound for one asynchronous transfer
+#endif
+
+#ifndef BME680_I2C_RETRIES
+#define BME680_I2C_RETRIES 2  // Repetitions of a failed I2C transaction
+#endif
+
+#ifndef BME680_I2C_RETRY_DELAY_US
+#define BME680_I2C_RETRY_DELAY_US 100  // Delay before the first repetition, doubled for each further one
+#endif
+
+#ifndef BME680_RECOVERY_ATTEMPTS
+#define BME680_RECOVERY_ATTEMPTS 1  // Readings repeated after a successful BME680#recover
+#endif
+
+#ifndef BME680_LOG_BUFFER_SIZE
+#define BME680_LOG_BUFFER_SIZE 512  // Debug log characters kept until BME680#flushLog
+#endif
+
+#ifndef BME680_LOG_LINE_SIZE
+#define BME680_LOG_LINE_SIZE 64  // Longest formatted debug log message
+#endif
+
+#ifndef BME680_WRITE_BUFFER_SIZE
+#define BME680_WRITE_BUFFER_SIZE BME680_TMP_BUFFER_LENGTH  // Largest register/value block built by bme680_set_regs()
+#endif
+
+#define BME680_HEATER_PROFILE_LEN 10  // Number of heater set-points of the sensor
+
+#define BME680_SNAPSHOT_VERSION 2
+#define BME680_SNAPSHOT_KEY_SIZE 24
+
+/**
+ * Calibration data and settings of a sensor, for a warm boot without calibration read.
+ */
+struct BME680Snapshot {
+    uint8_t version;
+    uint8_t chipId;
+    uint8_t address;
+    int8_t ambTemp;
+    struct bme680_calib_data calib;
+    struct bme680_tph_sett tphSettings;
+    struct bme680_gas_sett gasSettings;
+    uint8_t profileCount;  // Heater profile steps, 0 without a profile
+    uint16_t profileTemps[BME680_HEATER_PROFILE_LEN], profileTimes[BME680_HEATER_PROFILE_LEN];
+    uint32_t checksum;
+};
+
+/**
+ * Consistent copy of the latest compensated sample, see BME680#getLatest.
+ */
+struct BME680Reading {
+    uint32_t timestamp;  // Kernel::Clock time in milliseconds when the sample was read
+    int16_t temperature;  // Centi degree Celsius
+    uint32_t pressure;  // Pascal
+    uint32_t humidity;  // Milli % relative humidity
+    uint32_t gasResistance;  // Ohm
+    uint8_t status;  // BME680_NEW_DATA_MSK, BME680_GASM_VALID_MSK and BME680_HEAT_STAB_MSK bits
+};
+
+#ifndef BME680_MAX_INSTANCES
+#define BME680_MAX_INSTANCES 4  // Number of BME680 objects that can exist at the same time
+#endif
 
 
 /**
  * BME680 Class for I2C usage.
  * Wraps the Bosch library for MBed usage.
  */
-class BME680 {
+class BME680 : private NonCopyable<BME680> {
 public:
     BME680(PinName sda, PinName scl);
 
     BME680(uint8_t adr, PinName sda, PinName scl);
 
+    BME680(uint8_t adr, I2C &i2c);
+
+    ~BME680();
+
     bool begin();
 
+    bool begin(const BME680Snapshot &snapshot);
+
+    /**
+     * Initializes the sensor and writes a compile time configuration, see BME680Config
+     * @tparam Config BME680Config of the sensor
+     * @return True on success, False on failure
+     */
+    template<typename Config>
+    bool begin() {
+        return begin() && applyConfig(Config::image);
+    }
+
+    bool applyConfig(const BME680RegisterImage &image);
+
+    bool exportSnapshot(BME680Snapshot *snapshot);
+
+#ifdef BME680_USE_KVSTORE
+    bool saveSnapshot();
+
+    bool beginFromStore();
+#endif
+
+    int32_t getSensorID();
+
+#ifdef BME680_STATS
+    const BME680Stats &getStats();
+
+    void resetStats();
+#endif
+
+    void frequency(int hz);
+
     bool setTemperatureOversampling(uint8_t os);
 
     bool setPressureOversampling(uint8_t os);
@@ -30,15 +149,55 @@ public:
 
     bool setGasHeater(uint16_t heaterTemp, uint16_t heaterTime);
 
+    bool setHeaterProfile(const uint16_t *heaterTemps, const uint16_t *heaterTimes, uint8_t count);
+
+    uint8_t getHeaterProfileStep();
+
+    bool getHeaterProfileResult(uint8_t step, uint32_t *gasResistance);
+
+    void skipGasMeasurement(bool skip);
+
+    bool setGasDecimation(uint16_t decimation);
+
+    void setDirectMode(bool direct);
+
+    uint16_t getProfileDuration();
+
+    uint16_t getHeaterDuration();
+
     bool performReading();
 
+    bool performBurst(uint16_t count, BME680BurstStats *stats);
+
+    uint16_t startMeasurement();
+
+    bool startMeasurement(EventQueue &queue, Callback<void(bool)> done);
+
+    bool isMeasurementReady();
+
+    bool fetchResult();
+
     bool isGasHeatingSetupStable();
 
+    bool isGasMeasured();
+
     int16_t getRawTemperature();
     uint32_t getRawPressure();
     uint32_t getRawHumidity();
     uint32_t getRawGasResistance();
 
+    const struct bme680_field_data &getFieldData();
+
+    bool getLatest(BME680Reading *reading);
+
+    bool readRawFieldData(uint8_t buffer[BME680_FIELD_LENGTH]);
+
+    bool recover();
+
+    static bool clearBus(PinName sda, PinName scl);
+
+    static void flushLog();
+
     float getTemperature();
 
     float getPressure();
@@ -48,16 +207,109 @@ public:
     float getGasResistance();
 
 private:
-    I2C i2c;
+    I2C *_i2c;
+    /* Storage for the bus when it is owned by this instance, avoids a heap allocation.
+     * Instances created on a shared bus leave it unused, which costs sizeof(I2C) bytes per sensor. */
+    alignas(I2C) unsigned char _i2cBuffer[sizeof(I2C)];
+    bool _ownsI2c;
+    PinName _sda, _scl;  // Pins of the owned bus, NC for a shared one
+    int _frequency;  // Applied again after a clear of the owned bus, 0 for the I2C default
+    bool _sensorLost;  // The chip ID could not be read during the last recovery
+    char _writeBuffer[BME680_WRITE_BUFFER_SIZE];
+#if BME680_USE_I2C_ASYNCH
+    Semaphore _transferDone;
+    volatile int _transferEvent;
+#endif
     bool _filterEnabled, _tempEnabled, _humEnabled, _presEnabled, _gasEnabled;
+    uint16_t _dirtySettings;  // BME680_*_SEL groups changed since the last bme680_set_sensor_settings()
+    uint16_t _tphDuration;  // Cached conversion time without the heater phase, 0 when the setters changed it
+    bool _direct;  // Trigger with a single ctrl_meas write, see BME680#setDirectMode
     int32_t _sensorID;
     struct bme680_dev gas_sensor;
     struct bme680_field_data data;
+    PlatformMutex _mutex;  // Serializes the sensor operations, taken before the I2C lock
+    BME680Reading _latest[2];  // Double buffer written by BME680#publishLatest
+    volatile uint32_t _latestSeq;  // Twice the number of published samples, odd while one is written
+    BME680Compensation _compensation;
+    uint16_t _profileTemps[BME680_HEATER_PROFILE_LEN], _profileTimes[BME680_HEATER_PROFILE_LEN];
+    uint32_t _profileGas[BME680_HEATER_PROFILE_LEN];
+    uint16_t _profileValid;  // Bit n is set once step n has a stable gas reading
+    uint8_t _profileCount, _profileStep;
+    bool _gasSkipped;
+    uint16_t _gasDecimation, _gasCountdown;  // Gas runs when the countdown is 0, then restarts at decimation - 1
+    bool _gasMeasured;  // The running measurement includes the gas phase
+    bool _gasHeld;  // The last reading carries the gas resistance of an earlier reading
+    uint32_t _lastGas;  // Last stable gas resistance, 0 if none
+    uint8_t _ctrlGas1;  // Last value written to ctrl_gas_1
     uint8_t _adr;
+    uint8_t _slot;  // Index in BME680#_instances, passed to the Bosch API as dev_id
+    bool _measuring;
+    Kernel::Clock::time_point _measReadyAt;
+    Callback<void(bool)> _measDone;
+#ifdef BME680_STATS
+    BME680Stats _stats;
+    uint32_t _triggeredAt;  // us_ticker time of the last trigger
+#endif
+
+    void init(uint8_t adr, I2C *i2c, bool ownsI2c);
+
+    bool setupInterface();
+
+    void initialized();
+
+    static uint32_t snapshotChecksum(const BME680Snapshot &snapshot);
+
+#ifdef BME680_USE_KVSTORE
+    void snapshotKey(char key[BME680_SNAPSHOT_KEY_SIZE]);
+#endif
+
+    void onMeasurementDone();
+
+    bool writeHeaterProfile();
+
+    uint8_t selectHeaterProfileStep();
+
+    bool gasDue();
+
+    bool writeGasControl(uint8_t nbConv, bool runGas);
+
+    bool writeForcedMode();
+
+    uint16_t tphDuration();
+
+    static BME680 *_instances[BME680_MAX_INSTANCES];
+
+#ifdef BME680_DEBUG_MODE
+    static CircularBuffer<char, BME680_LOG_BUFFER_SIZE> _logBuffer;
 
     static void log(const char *format, ...);
+#endif
+
+    uint16_t triggerMeasurement();
+
+    bool readMeasurement();
+
+    bool measure();
+
+    bool readChipId();
+
+    bool resetBus();
+
+    void publishLatest();
+
+    int8_t transfer(const char *tx, int txLen, char *rx, int rxLen);
+
+    int8_t busTransaction(const char *tx, int txLen, char *rx, int rxLen);
+
+#if BME680_USE_I2C_ASYNCH
+    void onTransferDone(int event);
+#endif
+
+    int8_t busWrite(uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
+
+    int8_t busRead(uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
 
-    // BME680 - hardware interface
+    // BME680 - hardware interface, dispatches to the instance registered under dev_id
     static int8_t i2c_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
 
     static int8_t i2c_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
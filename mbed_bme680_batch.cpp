@@ -0,0 +1,45 @@
+#include "mbed_bme680_batch.h"
+
+/**
+ * Converts temperatures
+ * @param temperature Temperatures in centi degree Celsius
+ * @param out Receives the temperatures in degree Celsius
+ * @param count Number of values
+ */
+void BME680BatchKernels::toCelsius(const int16_t *__restrict temperature, float *__restrict out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = temperature[i] * 0.01f;
+}
+
+/**
+ * Converts pressures
+ * @param pressure Pressures in Pascal
+ * @param out Receives the pressures in Pascal
+ * @param count Number of values
+ */
+void BME680BatchKernels::toPascal(const uint32_t *__restrict pressure, float *__restrict out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = (float) (int32_t) pressure[i];  // Pressure fits 31 bit, signed conversion has a vector instruction
+}
+
+/**
+ * Converts humidities
+ * @param humidity Humidities in milli % relative humidity
+ * @param out Receives the humidities in % relative humidity
+ * @param count Number of values
+ */
+void BME680BatchKernels::toPercent(const uint32_t *__restrict humidity, float *__restrict out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = (int32_t) humidity[i] * 0.001f;  // At most 100000
+}
+
+/**
+ * Converts gas resistances
+ * @param gasResistance Gas resistances in Ohm
+ * @param out Receives the gas resistances in Ohm
+ * @param count Number of values
+ */
+void BME680BatchKernels::toOhm(const uint32_t *__restrict gasResistance, float *__restrict out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = (float) gasResistance[i];
+}
@@ -0,0 +1,174 @@
+#ifndef BME680_BATCH_H
+#define BME680_BATCH_H
+
+#include <stddef.h>
+
+#include "bme680.h"
+#include "mbed_bme680_compensation.h"
+
+/**
+ * Unit conversion kernels over contiguous columns, written as plain loops for auto-vectorization.
+ * The factors match the BME680 float getters.
+ */
+class BME680BatchKernels {
+public:
+    static void toCelsius(const int16_t *temperature, float *out, size_t count);
+
+    static void toPascal(const uint32_t *pressure, float *out, size_t count);
+
+    static void toPercent(const uint32_t *humidity, float *out, size_t count);
+
+    static void toOhm(const uint32_t *gasResistance, float *out, size_t count);
+};
+
+/**
+ * Structure of arrays store for up to N samples, e.g. of many sensors on a gateway.
+ * Samples are added either as raw field data blocks, compensated in one pass per column with
+ * BME680Batch#compensate, or as already compensated bme680_field_data.
+ * Each quantity is kept in its own contiguous column.
+ * BME680Batch#compensate applies one calibration set to all raw samples, raw samples of sensors with
+ * different calibrations need a batch each, or are compensated first and added with BME680Batch#add.
+ */
+template <size_t N>
+class BME680Batch {
+public:
+    BME680Batch() {
+        clear();
+    }
+
+    void clear() {
+        _count = 0;
+    }
+
+    size_t size() const {
+        return _count;
+    }
+
+    size_t capacity() const {
+        return N;
+    }
+
+    /**
+     * Adds a raw field data block, compensated with the next BME680Batch#compensate
+     * @param raw BME680_FIELD_LENGTH bytes read with BME680#readRawFieldData
+     * @return True on success, False if the batch is full
+     */
+    bool addRaw(const uint8_t raw[BME680_FIELD_LENGTH]) {
+        if (_count >= N)
+            return false;
+
+        _status[_count] = (raw[0] & BME680_NEW_DATA_MSK) | (raw[14] & (BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK));
+        _presAdc[_count] = ((uint32_t) raw[2] << 12) | ((uint32_t) raw[3] << 4) | ((uint32_t) raw[4] >> 4);
+        _tempAdc[_count] = ((uint32_t) raw[5] << 12) | ((uint32_t) raw[6] << 4) | ((uint32_t) raw[7] >> 4);
+        _humAdc[_count] = (uint16_t) (((uint32_t) raw[8] << 8) | (uint32_t) raw[9]);
+        _gasAdc[_count] = (uint16_t) (((uint32_t) raw[13] << 2) | ((uint32_t) raw[14] >> 6));
+        _gasRange[_count] = raw[14] & BME680_GAS_RANGE_MSK;
+        _raw[_count] = true;
+        _count++;
+
+        return true;
+    }
+
+    /**
+     * Adds a compensated sample, which must not be compensated again
+     * @param data Compensated field data
+     * @return True on success, False if the batch is full
+     */
+    bool add(const struct bme680_field_data &data) {
+        if (_count >= N)
+            return false;
+
+        _status[_count] = data.status;
+        _temperature[_count] = data.temperature;
+        _pressure[_count] = data.pressure;
+        _humidity[_count] = data.humidity;
+        _gasResistance[_count] = data.gas_resistance;
+        _raw[_count] = false;
+        _count++;
+
+        return true;
+    }
+
+    /**
+     * Compensates all samples added with BME680Batch#addRaw, samples added with BME680Batch#add are left as they are.
+     * Each run of consecutive raw samples is compensated in one pass per column.
+     * @param compensation Compensation loaded with the calibration of the sensor the samples came from
+     * @param first Index of the first sample to compensate, samples before it are left as they are
+     */
+    void compensate(const BME680Compensation &compensation, size_t first = 0) {
+        size_t start = first;
+
+        while (start < _count) {
+            if (!_raw[start]) {
+                start++;
+                continue;
+            }
+
+            size_t end = start + 1;
+
+            while (end < _count && _raw[end])
+                end++;
+
+            compensateRun(compensation, start, end - start);
+            start = end;
+        }
+    }
+
+    /**
+     * Converts all samples to the units of the BME680 float getters, each output may be NULL
+     * @param celsius Receives the temperatures in degree Celsius
+     * @param pascal Receives the pressures in Pascal
+     * @param percent Receives the humidities in % relative humidity
+     * @param ohm Receives the gas resistances in Ohm
+     */
+    void convert(float *celsius, float *pascal, float *percent, float *ohm) const {
+        if (celsius)
+            BME680BatchKernels::toCelsius(_temperature, celsius, _count);
+        if (pascal)
+            BME680BatchKernels::toPascal(_pressure, pascal, _count);
+        if (percent)
+            BME680BatchKernels::toPercent(_humidity, percent, _count);
+        if (ohm)
+            BME680BatchKernels::toOhm(_gasResistance, ohm, _count);
+    }
+
+    const uint8_t *getStatus() const {
+        return _status;
+    }
+
+    const int16_t *getTemperatures() const {
+        return _temperature;
+    }
+
+    const uint32_t *getPressures() const {
+        return _pressure;
+    }
+
+    const uint32_t *getHumidities() const {
+        return _humidity;
+    }
+
+    const uint32_t *getGasResistances() const {
+        return _gasResistance;
+    }
+
+private:
+    void compensateRun(const BME680Compensation &compensation, size_t first, size_t count) {
+        compensation.temperatures(_tempAdc + first, _tFine + first, _temperature + first, count);
+        compensation.pressures(_presAdc + first, _tFine + first, _pressure + first, count);
+        compensation.humidities(_humAdc + first, _tFine + first, _humidity + first, count);
+        compensation.gasResistances(_gasAdc + first, _gasRange + first, _gasResistance + first, count);
+    }
+
+    size_t _count;
+    bool _raw[N];  // Sample was added with BME680Batch#addRaw
+    uint8_t _status[N];
+    uint32_t _tempAdc[N], _presAdc[N];
+    uint16_t _humAdc[N], _gasAdc[N];
+    uint8_t _gasRange[N];
+    int32_t _tFine[N];
+    int16_t _temperature[N];
+    uint32_t _pressure[N], _humidity[N], _gasResistance[N];
+};
+
+#endif
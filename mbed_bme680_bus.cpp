@@ -0,0 +1,140 @@
+#include "mbed_bme680_bus.h"
+
+#include <new>
+
+BME680Bus::BME680Bus(PinName sda, PinName scl) : _i2c(sda, scl) {
+    _sda = sda;
+    _scl = scl;
+    _frequency = 0;
+    _sensorCount = 0;
+    _busClears = 0;
+}
+
+/**
+ * Get the bus to construct the sensors with, see BME680#BME680(uint8_t, I2C &)
+ * @return Shared I2C bus
+ */
+I2C &BME680Bus::getI2C() {
+    return _i2c;
+}
+
+/**
+ * Adds a sensor to the measurement cycle.
+ * The sensor must be created on BME680Bus#getI2C and initialized with BME680#begin.
+ * @param sensor Sensor to add
+ * @return True on success, False if BME680_BUS_MAX_SENSORS are already attached
+ */
+bool BME680Bus::attach(BME680 &sensor) {
+    if (_sensorCount >= BME680_BUS_MAX_SENSORS) return false;
+
+    _sensors[_sensorCount++] = &sensor;
+
+    return true;
+}
+
+/**
+ * Sets the bus frequency, kept across bus clears
+ * @param hz Bus frequency in Hz
+ */
+void BME680Bus::frequency(int hz) {
+    _frequency = hz;
+    _i2c.frequency(hz);
+}
+
+uint8_t BME680Bus::getSensorCount() {
+    return _sensorCount;
+}
+
+BME680 &BME680Bus::getSensor(uint8_t index) {
+    MBED_ASSERT(index < _sensorCount);
+
+    return *_sensors[index];
+}
+
+/**
+ * Performs a reading of all attached sensors.
+ * Costs roughly one measurement duration of the slowest sensor instead of the sum of all of them.
+ * If sensors fail, BME680Bus#recover runs for them afterwards so the next call can succeed.
+ * @return Bit mask of the sensors read successfully, bit n is set for the n-th attached sensor
+ */
+uint32_t BME680Bus::performReadings() {
+    uint32_t started = 0, success = 0;
+    uint16_t longest = 0;
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        uint16_t meas_period = _sensors[i]->startMeasurement();
+
+        if (meas_period == 0)
+            continue;
+
+        started |= 1UL << i;
+
+        if (meas_period > longest)
+            longest = meas_period;
+    }
+
+    if (started == 0)
+        return 0;
+
+    ThisThread::sleep_for(std::chrono::milliseconds(longest));
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        if ((started & (1UL << i)) && _sensors[i]->fetchResult())
+            success |= 1UL << i;
+    }
+
+    uint32_t failed = ((1UL << _sensorCount) - 1) & ~success;
+
+    if (failed != 0)
+        recover(failed);
+
+    return success;
+}
+
+/**
+ * Recovers sensors with BME680#recover. Only if one of them does not answer with its chip ID the bus is
+ * cleared by toggling SCL and those sensors are recovered again, a sensor that merely missed a reading
+ * does not disturb the others.
+ * The I2C object is constructed again for the clear, so it must not be in use by another thread.
+ * @param sensors Bit mask of the sensors to recover, bit n for the n-th attached sensor, all by default
+ * @return True if the sensors are ready for the next reading
+ */
+bool BME680Bus::recover(uint32_t sensors) {
+    uint32_t lost = 0;
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        if ((sensors & (1UL << i)) && !_sensors[i]->recover())
+            lost |= 1UL << i;
+    }
+
+    if (lost == 0)
+        return true;
+
+    clearBus();
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        if ((lost & (1UL << i)) && _sensors[i]->recover())
+            lost &= ~(1UL << i);
+    }
+
+    return lost == 0;
+}
+
+/**
+ * Get the number of bus clears done by BME680Bus#recover
+ * @return Bus clears since construction
+ */
+uint32_t BME680Bus::getBusClears() {
+    return _busClears;
+}
+
+void BME680Bus::clearBus() {
+    _i2c.~I2C();
+    BME680::clearBus(_sda, _scl);
+    new(&_i2c) I2C(_sda, _scl);
+
+    if (_frequency != 0)
+        _i2c.frequency(_frequency);
+
+    _busClears++;
+}
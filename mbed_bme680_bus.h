@@ -0,0 +1,51 @@
+#ifndef BME680_BUS_H
+#define BME680_BUS_H
+
+#include "mbed.h"
+#include "mbed_bme680.h"
+
+#ifndef BME680_BUS_MAX_SENSORS
+#define BME680_BUS_MAX_SENSORS 2  // A BME680 can only use address 0x76 or 0x77
+#endif
+
+static_assert(BME680_BUS_MAX_SENSORS < 32, "BME680_BUS_MAX_SENSORS must fit the 32 bit sensor masks");
+
+/**
+ * Shares one I2C bus between several BME680 and measures them in parallel.
+ * All sensors are triggered back-to-back, the bus manager sleeps once for the longest
+ * measurement duration and reads them all afterwards.
+ * Each bus manager is independent, so several buses can be serviced from separate threads.
+ * After a failed reading the failed sensors are recovered, see BME680Bus#recover.
+ */
+class BME680Bus : private NonCopyable<BME680Bus> {
+public:
+    BME680Bus(PinName sda, PinName scl);
+
+    I2C &getI2C();
+
+    bool attach(BME680 &sensor);
+
+    void frequency(int hz);
+
+    uint8_t getSensorCount();
+
+    BME680 &getSensor(uint8_t index);
+
+    uint32_t performReadings();
+
+    bool recover(uint32_t sensors = UINT32_MAX);
+
+    uint32_t getBusClears();
+
+private:
+    I2C _i2c;
+    PinName _sda, _scl;
+    int _frequency;  // Applied again after a bus clear, 0 for the I2C default
+    BME680 *_sensors[BME680_BUS_MAX_SENSORS];
+    uint8_t _sensorCount;
+    uint32_t _busClears;
+
+    void clearBus();
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "mbed_bme680_change_detector.h"
+#include "mbed_bme680_thresholds.h"
+
+BME680ChangeDetector::BME680ChangeDetector() {
+    _tempThreshold = BME680_DEFAULT_TEMP_THRESHOLD;
+    _presThreshold = BME680_DEFAULT_PRES_THRESHOLD;
+    _humThreshold = BME680_DEFAULT_HUM_THRESHOLD;
+    _gasPercent = BME680_DEFAULT_GAS_PERCENT;
+    _heartbeat = 15 * 60 * 1000;
+    _reported = _suppressed = 0;
+    reset();
+}
+
+/**
+ * Setter for the deadbands around the last reported sample
+ * @param temperature Temperature deadband in centi degree celsius
+ * @param pressure Pressure deadband in Pascal
+ * @param humidity Humidity deadband in milli % relative humidity
+ * @param gasPercent Gas resistance deadband in percent of the last reported gas resistance
+ */
+void BME680ChangeDetector::setThresholds(int16_t temperature, uint32_t pressure, uint32_t humidity, uint8_t gasPercent) {
+    _tempThreshold = temperature;
+    _presThreshold = pressure;
+    _humThreshold = humidity;
+    _gasPercent = gasPercent;
+}
+
+/**
+ * Setter for the longest time without a report
+ * @param interval Heartbeat interval, 0 for no heartbeat
+ */
+void BME680ChangeDetector::setHeartbeat(std::chrono::milliseconds interval) {
+    _heartbeat = (uint32_t) interval.count();
+}
+
+/**
+ * Sets the callback for reported samples, called from BME680ChangeDetector#update.
+ * Post into an EventQueue (EventQueue#event) to handle the reports on another thread.
+ * @param report Called with the sample and the BME680_CHANGE_* reasons
+ */
+void BME680ChangeDetector::attach(Callback<void(const BME680Sample &, uint8_t)> report) {
+    _report = report;
+}
+
+/**
+ * Checks a sample and reports it if needed. The first sample is always reported.
+ * @param sample Next sample of the stream
+ * @return BME680_CHANGE_* reasons the sample was reported for, 0 if it was suppressed
+ */
+uint8_t BME680ChangeDetector::update(const BME680Sample &sample) {
+    uint8_t reasons = changes(sample);
+
+    if (reasons == 0) {
+        _suppressed++;
+        return 0;
+    }
+
+    _reference = sample;
+    _hasReference = true;
+
+    if ((sample.data.status & BME680_GASM_VALID_MSK) && (sample.data.status & BME680_HEAT_STAB_MSK)) {
+        _gasReference = sample.data.gas_resistance;
+        _hasGasReference = true;
+    }
+
+    _reported++;
+
+    if (_report)
+        _report(sample, reasons);
+
+    return reasons;
+}
+
+/**
+ * Forgets the last reported sample, the next sample is reported
+ */
+void BME680ChangeDetector::reset() {
+    _hasReference = _hasGasReference = false;
+    _gasReference = 0;
+}
+
+/**
+ * @return Number of reported samples
+ */
+uint32_t BME680ChangeDetector::getReported() {
+    return _reported;
+}
+
+/**
+ * @return Number of suppressed samples
+ */
+uint32_t BME680ChangeDetector::getSuppressed() {
+    return _suppressed;
+}
+
+uint8_t BME680ChangeDetector::changes(const BME680Sample &sample) {
+    const struct bme680_field_data &data = sample.data;
+    uint8_t reasons = 0;
+
+    if (!_hasReference)
+        return BME680_CHANGE_TEMPERATURE | BME680_CHANGE_PRESSURE | BME680_CHANGE_HUMIDITY | BME680_CHANGE_GAS;
+
+    int32_t tempDelta = (int32_t) data.temperature - _reference.data.temperature;
+
+    if (tempDelta > _tempThreshold || tempDelta < -_tempThreshold)
+        reasons |= BME680_CHANGE_TEMPERATURE;
+
+    if (absDiff(data.pressure, _reference.data.pressure) > _presThreshold)
+        reasons |= BME680_CHANGE_PRESSURE;
+
+    if (absDiff(data.humidity, _reference.data.humidity) > _humThreshold)
+        reasons |= BME680_CHANGE_HUMIDITY;
+
+    if ((data.status & BME680_GASM_VALID_MSK) && (data.status & BME680_HEAT_STAB_MSK)) {
+        if (!_hasGasReference) {
+            reasons |= BME680_CHANGE_GAS;
+        } else {
+            uint64_t limit = (uint64_t) _gasReference * _gasPercent / 100;
+
+            if (absDiff(data.gas_resistance, _gasReference) > limit)
+                reasons |= BME680_CHANGE_GAS;
+        }
+    }
+
+    if (_heartbeat > 0 && sample.timestamp - _reference.timestamp >= _heartbeat)
+        reasons |= BME680_CHANGE_HEARTBEAT;
+
+    return reasons;
+}
@@ -0,0 +1,51 @@
+#ifndef BME680_CHANGE_DETECTOR_H
+#define BME680_CHANGE_DETECTOR_H
+
+#include "mbed.h"
+#include "mbed_bme680_sampler.h"
+
+/* Reasons passed to the BME680ChangeDetector callback */
+#define BME680_CHANGE_TEMPERATURE 0x01
+#define BME680_CHANGE_PRESSURE 0x02
+#define BME680_CHANGE_HUMIDITY 0x04
+#define BME680_CHANGE_GAS 0x08
+#define BME680_CHANGE_HEARTBEAT 0x10
+
+/**
+ * Report by exception on top of a sample stream, e.g. the samples popped from a BME680Sampler.
+ * A sample is reported when a channel moved beyond its deadband around the last reported sample,
+ * or when the heartbeat interval passed without a report. Works on the integer field data only.
+ */
+class BME680ChangeDetector {
+public:
+    BME680ChangeDetector();
+
+    void setThresholds(int16_t temperature, uint32_t pressure, uint32_t humidity, uint8_t gasPercent);
+
+    void setHeartbeat(std::chrono::milliseconds interval);
+
+    void attach(Callback<void(const BME680Sample &, uint8_t)> report);
+
+    uint8_t update(const BME680Sample &sample);
+
+    void reset();
+
+    uint32_t getReported();
+
+    uint32_t getSuppressed();
+
+private:
+    int16_t _tempThreshold;
+    uint32_t _presThreshold, _humThreshold;
+    uint8_t _gasPercent;
+    uint32_t _heartbeat;
+    Callback<void(const BME680Sample &, uint8_t)> _report;
+    bool _hasReference, _hasGasReference;
+    BME680Sample _reference;  // Last reported sample
+    uint32_t _gasReference;  // Gas resistance of the last reported sample with a stable gas reading
+    uint32_t _reported, _suppressed;
+
+    uint8_t changes(const BME680Sample &sample);
+};
+
+#endif
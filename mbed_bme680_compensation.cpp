@@ -0,0 +1,272 @@
+#include "mbed_bme680_compensation.h"
+
+/* Gas range constants from the Bosch API */
+static const uint32_t gasRangeTable1[16] = {
+        2147483647UL, 2147483647UL, 2147483647UL, 2147483647UL, 2147483647UL, 2126008810UL, 2147483647UL, 2130303777UL,
+        2147483647UL, 2147483647UL, 2143188679UL, 2136746228UL, 2147483647UL, 2126008810UL, 2147483647UL, 2147483647UL
+};
+
+static const uint32_t gasRangeTable2[16] = {
+        4096000000UL, 2048000000UL, 1024000000UL, 512000000UL, 255744255UL, 127110228UL, 64000000UL, 32258064UL,
+        16016016UL, 8000000UL, 4000000UL, 2000000UL, 1000000UL, 500000UL, 250000UL, 125000UL
+};
+
+BME680Compensation::BME680Compensation() {
+    _loaded = false;
+}
+
+/**
+ * Precomputes the coefficients from the calibration block read by bme680_init()
+ * @param calib Calibration data of the sensor
+ */
+void BME680Compensation::load(const struct bme680_calib_data &calib) {
+    _t1x2 = (int32_t) calib.par_t1 << 1;
+    _t2 = calib.par_t2;
+    _t3x16 = (int32_t) calib.par_t3 << 4;
+
+    _p1 = calib.par_p1;
+    _p2 = calib.par_p2;
+    _p3x32 = (int32_t) calib.par_p3 << 5;
+    _p4x65536 = (int32_t) calib.par_p4 << 16;
+    _p5 = calib.par_p5;
+    _p6 = calib.par_p6;
+    _p7x128 = (int32_t) calib.par_p7 << 7;
+    _p8 = calib.par_p8;
+    _p9 = calib.par_p9;
+    _p10 = calib.par_p10;
+
+    _h1x16 = (int32_t) calib.par_h1 * 16;
+    _h2 = calib.par_h2;
+    _h3 = calib.par_h3;
+    _h4 = calib.par_h4;
+    _h5 = calib.par_h5;
+    _h6x128 = (int32_t) calib.par_h6 << 7;
+    _h7 = calib.par_h7;
+
+    _gh1 = calib.par_gh1;
+    _gh2 = calib.par_gh2;
+    _gh3 = calib.par_gh3;
+    _heatRange = calib.res_heat_range;
+    _heatVal = calib.res_heat_val;
+
+    for (uint8_t range = 0; range < 16; range++) {
+        _gasVar1[range] = (int32_t) (((1340 + (5 * (int64_t) calib.range_sw_err)) * (int64_t) gasRangeTable1[range]) >> 16);
+        _gasVar3[range] = ((int64_t) gasRangeTable2[range] * _gasVar1[range]) >> 9;
+    }
+
+    _loaded = true;
+}
+
+bool BME680Compensation::isLoaded() const {
+    return _loaded;
+}
+
+/**
+ * Compensates a temperature ADC value
+ * @param adc 20 bit temperature ADC value
+ * @param t_fine Receives the fine temperature used by the pressure and humidity compensation
+ * @return Temperature in centi degree Celsius
+ */
+int16_t BME680Compensation::temperature(uint32_t adc, int32_t *t_fine) const {
+    int64_t var1, var2, var3;
+
+    var1 = ((int32_t) adc >> 3) - _t1x2;
+    var2 = (var1 * _t2) >> 11;
+    var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
+    var3 = (var3 * _t3x16) >> 14;
+    *t_fine = (int32_t) (var2 + var3);
+
+    return (int16_t) (((*t_fine * 5) + 128) >> 8);
+}
+
+/**
+ * Compensates a pressure ADC value
+ * @param adc 20 bit pressure ADC value
+ * @param t_fine Fine temperature of the same sample
+ * @return Pressure in Pascal
+ */
+uint32_t BME680Compensation::pressure(uint32_t adc, int32_t t_fine) const {
+    int32_t var1, var2, var3, pressure_comp;
+
+    var1 = (t_fine >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * _p6) >> 2;
+    var2 = var2 + ((var1 * _p5) << 1);
+    var2 = (var2 >> 2) + _p4x65536;
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * _p3x32) >> 3) + ((_p2 * var1) >> 1);
+    var1 = var1 >> 18;
+    var1 = ((32768 + var1) * _p1) >> 15;
+
+    if (var1 == 0)
+        return 0;
+
+    pressure_comp = 1048576 - (int32_t) adc;
+    pressure_comp = (int32_t) ((pressure_comp - (var2 >> 12)) * ((uint32_t) 3125));
+
+    if (pressure_comp >= 0x40000000)
+        pressure_comp = ((pressure_comp / var1) << 1);
+    else
+        pressure_comp = ((pressure_comp << 1) / var1);
+
+    var1 = (_p9 * (int32_t) (((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((pressure_comp >> 2) * _p8) >> 13;
+    var3 = ((pressure_comp >> 8) * (pressure_comp >> 8) * (pressure_comp >> 8) * _p10) >> 17;
+    pressure_comp = pressure_comp + ((var1 + var2 + var3 + _p7x128) >> 4);
+
+    return (uint32_t) pressure_comp;
+}
+
+/**
+ * Compensates a humidity ADC value
+ * @param adc 16 bit humidity ADC value
+ * @param t_fine Fine temperature of the same sample
+ * @return Humidity in milli % relative humidity
+ */
+uint32_t BME680Compensation::humidity(uint16_t adc, int32_t t_fine) const {
+    int32_t var1, var2, var3, var4, var5, var6, temp_scaled, calc_hum;
+
+    temp_scaled = ((t_fine * 5) + 128) >> 8;
+    var1 = (int32_t) (adc - _h1x16) - (((temp_scaled * _h3) / 100) >> 1);
+    var2 = (_h2 * (((temp_scaled * _h4) / 100)
+            + (((temp_scaled * ((temp_scaled * _h5) / 100)) >> 6) / 100) + (1 << 14))) >> 10;
+    var3 = var1 * var2;
+    var4 = (_h6x128 + ((temp_scaled * _h7) / 100)) >> 4;
+    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+    var6 = (var4 * var5) >> 1;
+    calc_hum = (((var3 + var6) >> 10) * 1000) >> 12;
+
+    if (calc_hum > 100000)
+        calc_hum = 100000;
+    else if (calc_hum < 0)
+        calc_hum = 0;
+
+    return (uint32_t) calc_hum;
+}
+
+/**
+ * Compensates a gas resistance ADC value
+ * @param adc 10 bit gas resistance ADC value
+ * @param range Gas range reported with the ADC value
+ * @return Gas resistance in Ohm
+ */
+uint32_t BME680Compensation::gasResistance(uint16_t adc, uint8_t range) const {
+    range &= BME680_GAS_RANGE_MSK;
+
+    int32_t var2 = (((int32_t) adc << 15) - 16777216) + _gasVar1[range];
+
+    if (var2 == 0)
+        return 0;
+
+    return (uint32_t) ((_gasVar3[range] + (var2 >> 1)) / var2);
+}
+
+/**
+ * Decodes and compensates a field data block read with BME680#readRawFieldData
+ * @param raw BME680_FIELD_LENGTH bytes starting at BME680_FIELD0_ADDR
+ * @param out Receives the status and the compensated values, left unchanged if the block holds no new data
+ * @return True if the block holds a new measurement
+ */
+bool BME680Compensation::compensate(const uint8_t raw[BME680_FIELD_LENGTH], struct bme680_field_data *out) const {
+    struct bme680_field_data data;
+    int32_t t_fine;
+
+    if (!(raw[0] & BME680_NEW_DATA_MSK))
+        return false;
+
+    data.status = raw[0] & BME680_NEW_DATA_MSK;
+    data.gas_index = raw[0] & BME680_GAS_INDEX_MSK;
+    data.meas_index = raw[1];
+    data.status |= raw[14] & BME680_GASM_VALID_MSK;
+    data.status |= raw[14] & BME680_HEAT_STAB_MSK;
+
+    uint32_t adc_pres = ((uint32_t) raw[2] << 12) | ((uint32_t) raw[3] << 4) | ((uint32_t) raw[4] >> 4);
+    uint32_t adc_temp = ((uint32_t) raw[5] << 12) | ((uint32_t) raw[6] << 4) | ((uint32_t) raw[7] >> 4);
+    uint16_t adc_hum = (uint16_t) (((uint32_t) raw[8] << 8) | (uint32_t) raw[9]);
+    uint16_t adc_gas_res = (uint16_t) (((uint32_t) raw[13] << 2) | ((uint32_t) raw[14] >> 6));
+
+    data.temperature = temperature(adc_temp, &t_fine);
+    data.pressure = pressure(adc_pres, t_fine);
+    data.humidity = humidity(adc_hum, t_fine);
+    data.gas_resistance = gasResistance(adc_gas_res, raw[14] & BME680_GAS_RANGE_MSK);
+
+    *out = data;
+    return true;
+}
+
+/*
+ * Column kernels for batches of samples. Each quantity runs in its own pass over contiguous arrays so
+ * the per sample functions above are inlined into simple loops the compiler can vectorize.
+ */
+
+/**
+ * Compensates a column of temperature ADC values
+ * @param adc 20 bit temperature ADC values
+ * @param t_fine Receives the fine temperatures for BME680Compensation#pressures and BME680Compensation#humidities
+ * @param out Receives the temperatures in centi degree Celsius
+ * @param count Number of values
+ */
+void BME680Compensation::temperatures(const uint32_t *__restrict adc, int32_t *__restrict t_fine,
+                                      int16_t *__restrict out, size_t count) const {
+    for (size_t i = 0; i < count; i++)
+        out[i] = temperature(adc[i], &t_fine[i]);
+}
+
+/**
+ * Compensates a column of pressure ADC values
+ * @param adc 20 bit pressure ADC values
+ * @param t_fine Fine temperatures of the same samples
+ * @param out Receives the pressures in Pascal
+ * @param count Number of values
+ */
+void BME680Compensation::pressures(const uint32_t *__restrict adc, const int32_t *__restrict t_fine,
+                                   uint32_t *__restrict out, size_t count) const {
+    for (size_t i = 0; i < count; i++)
+        out[i] = pressure(adc[i], t_fine[i]);
+}
+
+/**
+ * Compensates a column of humidity ADC values
+ * @param adc 16 bit humidity ADC values
+ * @param t_fine Fine temperatures of the same samples
+ * @param out Receives the humidities in milli % relative humidity
+ * @param count Number of values
+ */
+void BME680Compensation::humidities(const uint16_t *__restrict adc, const int32_t *__restrict t_fine,
+                                    uint32_t *__restrict out, size_t count) const {
+    for (size_t i = 0; i < count; i++)
+        out[i] = humidity(adc[i], t_fine[i]);
+}
+
+/**
+ * Compensates a column of gas resistance ADC values
+ * @param adc 10 bit gas resistance ADC values
+ * @param range Gas ranges reported with the ADC values
+ * @param out Receives the gas resistances in Ohm
+ * @param count Number of values
+ */
+void BME680Compensation::gasResistances(const uint16_t *__restrict adc, const uint8_t *__restrict range,
+                                        uint32_t *__restrict out, size_t count) const {
+    for (size_t i = 0; i < count; i++)
+        out[i] = gasResistance(adc[i], range[i]);
+}
+
+/**
+ * Computes the res_heat_x register value for a heater set-point
+ * @param temp Target heater temperature in degree Celsius, limited to 400
+ * @param ambTemp Ambient temperature in degree Celsius
+ * @return Heater resistance register value
+ */
+uint8_t BME680Compensation::heaterResistance(uint16_t temp, int8_t ambTemp) const {
+    int32_t var1, var2, var3, var4, var5, heatr_res_x100;
+
+    if (temp > 400)
+        temp = 400;
+
+    var1 = (((int32_t) ambTemp * _gh3) / 1000) * 256;
+    var2 = (_gh1 + 784) * (((((_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
+    var3 = var1 + (var2 / 2);
+    var4 = (var3 / (_heatRange + 4));
+    var5 = (131 * _heatVal) + 65536;
+    heatr_res_x100 = ((var4 / var5) - 250) * 34;
+
+    return (uint8_t) ((heatr_res_x100 + 50) / 100);
+}
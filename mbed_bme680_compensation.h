@@ -0,0 +1,72 @@
+#ifndef BME680_COMPENSATION_H
+#define BME680_COMPENSATION_H
+
+#include <stddef.h>
+
+#include "bme680.h"
+
+/**
+ * Integer compensation of the BME680 ADC values.
+ * The calibration block is converted once into pre-shifted coefficients and per gas range
+ * constants, the per sample path only uses integer arithmetic.
+ * Results use the Bosch API units: centi degree Celsius, Pascal, milli % relative humidity and Ohm.
+ */
+class BME680Compensation {
+public:
+    BME680Compensation();
+
+    void load(const struct bme680_calib_data &calib);
+
+    bool isLoaded() const;
+
+    int16_t temperature(uint32_t adc, int32_t *t_fine) const;
+
+    uint32_t pressure(uint32_t adc, int32_t t_fine) const;
+
+    uint32_t humidity(uint16_t adc, int32_t t_fine) const;
+
+    uint32_t gasResistance(uint16_t adc, uint8_t range) const;
+
+    bool compensate(const uint8_t raw[BME680_FIELD_LENGTH], struct bme680_field_data *out) const;
+
+    void temperatures(const uint32_t *adc, int32_t *t_fine, int16_t *out, size_t count) const;
+
+    void pressures(const uint32_t *adc, const int32_t *t_fine, uint32_t *out, size_t count) const;
+
+    void humidities(const uint16_t *adc, const int32_t *t_fine, uint32_t *out, size_t count) const;
+
+    void gasResistances(const uint16_t *adc, const uint8_t *range, uint32_t *out, size_t count) const;
+
+    uint8_t heaterResistance(uint16_t temp, int8_t ambTemp) const;
+
+    /**
+     * Computes the gas_wait_x register value for a heating duration
+     * @param duration Heating duration in milliseconds, limited to 4032
+     * @return Gas wait register value (6 bit value with a 2 bit multiplication factor)
+     */
+    static constexpr uint8_t heaterDuration(uint16_t duration) {
+        uint8_t factor = 0;
+
+        if (duration >= 0xfc0)
+            return 0xff;
+
+        while (duration > 0x3f) {
+            duration = duration / 4;
+            factor += 1;
+        }
+
+        return (uint8_t) (duration + (factor * 64));
+    }
+
+private:
+    bool _loaded;
+
+    int32_t _t1x2, _t2, _t3x16;
+    int32_t _p1, _p2, _p3x32, _p4x65536, _p5, _p6, _p7x128, _p8, _p9, _p10;
+    int32_t _h1x16, _h2, _h3, _h4, _h5, _h6x128, _h7;
+    int32_t _gh1, _gh2, _gh3, _heatRange, _heatVal;
+    int32_t _gasVar1[16];  // Per gas range, depends only on range_sw_err
+    int64_t _gasVar3[16];
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef BME680_CONFIG_H
+#define BME680_CONFIG_H
+
+#include "bme680.h"
+#include "mbed_bme680_compensation.h"
+
+/**
+ * Register values and derived constants of a fixed configuration, see BME680Config.
+ * res_heat_0 depends on the calibration data and is computed when the image is applied.
+ */
+struct BME680RegisterImage {
+    uint8_t osTemp, osPres, osHum, filter;
+    uint8_t ctrlHum;  // ctrl_hum, humidity oversampling
+    uint8_t ctrlMeas;  // ctrl_meas in sleep mode, temperature and pressure oversampling
+    uint8_t config;  // config, IIR filter
+    uint8_t ctrlGas1;  // ctrl_gas_1, run_gas with heater set-point 0
+    uint8_t gasWait0;  // gas_wait_0
+    uint16_t heaterTemp, heaterDur;
+    uint16_t selectMask;  // BME680_*_SEL groups covered by the image
+    uint16_t tphDuration;  // Temperature, pressure and humidity conversion time in milliseconds
+    uint16_t profileDuration;  // Complete measurement time in milliseconds
+};
+
+/**
+ * Heater set-point of a BME680Config.
+ * @tparam Temp Heater temperature in degree Celsius, up to 400
+ * @tparam Time Heating duration in milliseconds, up to 4032
+ */
+template<uint16_t Temp, uint16_t Time>
+struct BME680Heater {
+    static_assert(Temp > 0 && Temp <= 400, "BME680Heater temperature must be 1 to 400 degree Celsius");
+    static_assert(Time > 0 && Time < 0xfc0, "BME680Heater duration must be 1 to 4031 ms");
+
+    static constexpr uint16_t temperature = Temp;
+    static constexpr uint16_t duration = Time;
+};
+
+/**
+ * No gas measurement.
+ */
+struct BME680NoHeater {
+    static constexpr uint16_t temperature = 0;
+    static constexpr uint16_t duration = 0;
+};
+
+/**
+ * Compile time sensor configuration, e.g.
+ * BME680Config<BME680_OS_8X, BME680_OS_4X, BME680_OS_2X, BME680_FILTER_SIZE_3, BME680Heater<320, 150>>.
+ * The settings are checked with static_assert and turned into a register image, which BME680#applyConfig
+ * writes in a single transaction.
+ * The configuration is not carried into the read path: BME680#performReading still branches on the enable
+ * flags and the settings groups at runtime, the saving is the settings write and the duration computation.
+ * @tparam OsTemp Temperature oversampling, BME680_OS_NONE to BME680_OS_16X
+ * @tparam OsPres Pressure oversampling, BME680_OS_NONE to BME680_OS_16X
+ * @tparam OsHum Humidity oversampling, BME680_OS_NONE to BME680_OS_16X
+ * @tparam Filter IIR filter size, BME680_FILTER_SIZE_0 to BME680_FILTER_SIZE_127
+ * @tparam Heater BME680Heater set-point or BME680NoHeater
+ */
+template<uint8_t OsTemp, uint8_t OsPres, uint8_t OsHum, uint8_t Filter, typename Heater = BME680NoHeater>
+struct BME680Config {
+    static_assert(OsTemp <= BME680_OS_16X, "BME680Config temperature oversampling out of range");
+    static_assert(OsPres <= BME680_OS_16X, "BME680Config pressure oversampling out of range");
+    static_assert(OsHum <= BME680_OS_16X, "BME680Config humidity oversampling out of range");
+    static_assert(Filter <= BME680_FILTER_SIZE_127, "BME680Config filter size out of range");
+
+    /* Measurement cycles per oversampling setting, as in bme680_get_profile_dur() */
+    static constexpr uint16_t cycles = (OsTemp ? 1 << (OsTemp - 1) : 0) + (OsPres ? 1 << (OsPres - 1) : 0)
+                                       + (OsHum ? 1 << (OsHum - 1) : 0);
+
+    static constexpr uint16_t tphDuration = (uint16_t) ((cycles * 1963UL + 477 * 4 + 477 * 5 + 500) / 1000 + 1);
+
+    static constexpr BME680RegisterImage image = {
+            OsTemp, OsPres, OsHum, Filter,
+            OsHum,
+            (uint8_t) ((OsTemp << 5) | (OsPres << 2)),
+            (uint8_t) (Filter << 2),
+            (uint8_t) (Heater::duration > 0 ? BME680_RUN_GAS_MSK : 0),
+            BME680Compensation::heaterDuration(Heater::duration),
+            Heater::temperature, Heater::duration,
+            BME680_OST_SEL | BME680_OSP_SEL | BME680_OSH_SEL | BME680_FILTER_SEL | BME680_GAS_SENSOR_SEL,
+            tphDuration,
+            (uint16_t) (tphDuration + Heater::duration)
+    };
+};
+
+template<uint8_t OsTemp, uint8_t OsPres, uint8_t OsHum, uint8_t Filter, typename Heater>
+constexpr BME680RegisterImage BME680Config<OsTemp, OsPres, OsHum, Filter, Heater>::image;
+
+#endif
@@ -0,0 +1,179 @@
+#include "mbed_bme680_derived.h"
+
+#define CACHED_VAPOUR_PRESSURE 0x01
+#define CACHED_DEW_POINT 0x02
+#define CACHED_ABSOLUTE_HUMIDITY 0x04
+#define CACHED_ALTITUDE 0x08
+
+/* Saturation vapour pressure over water in deci Pascal, -40 to 85 degC in 2.5 degC steps */
+#define SVP_MIN_TEMP (-4000)
+#define SVP_STEP 250
+#define SVP_LEN 51
+
+static const uint32_t svpTable[SVP_LEN] = {
+        190, 246, 316, 403, 512, 646, 811, 1013, 1260, 1558,
+        1919, 2352, 2870, 3488, 4222, 5090, 6112, 7313, 8717, 10356,
+        12260, 14467, 17017, 19953, 23326, 27189, 31601, 36627, 42337, 48810,
+        56128, 64384, 73675, 84107, 95797, 108868, 123452, 139692, 157742, 177764,
+        199933, 224435, 251467, 281240, 313977, 349913, 389299, 432398, 479489, 530865,
+        586834
+};
+
+/* Altitude in cm for pressure / sea level pressure ratios of 0.25 to 1.125 in 1/64 steps, Q16 ratios */
+#define ALT_MIN_RATIO 16384
+#define ALT_STEP_BITS 10
+#define ALT_LEN 57
+
+static const int32_t altitudeTable[ALT_LEN] = {
+        1027909, 988398, 950727, 914714, 880204, 847065, 815179, 784446,
+        754777, 726093, 698323, 671404, 645282, 619904, 595225, 571203,
+        547801, 524984, 502720, 480980, 459737, 438967, 418646, 398754,
+        379271, 360178, 341459, 323097, 305077, 287387, 270011, 252939,
+        236159, 219659, 203430, 187461, 171745, 156270, 141031, 126018,
+        111225, 96644, 82269, 68093, 54110, 40315, 26702, 13265,
+        0, -13098, -26034, -38813, -51438, -63913, -76243, -88431,
+        -100481
+};
+
+BME680DerivedMetrics::BME680DerivedMetrics() {
+    _seaLevelPressure = BME680_SEA_LEVEL_PRESSURE;
+    update(0, 0, 0);
+}
+
+/**
+ * Setter for the reference pressure of the altitude
+ * @param pressure Current sea level pressure in Pascal
+ */
+void BME680DerivedMetrics::setSeaLevelPressure(uint32_t pressure) {
+    _seaLevelPressure = pressure > 0 ? pressure : BME680_SEA_LEVEL_PRESSURE;
+    _cached &= ~CACHED_ALTITUDE;
+}
+
+/**
+ * Sets a new sample and drops the cached values
+ * @param temperature Temperature in centi degree celsius
+ * @param pressure Pressure in Pascal
+ * @param humidity Humidity in milli % relative humidity
+ */
+void BME680DerivedMetrics::update(int16_t temperature, uint32_t pressure, uint32_t humidity) {
+    _temperature = temperature;
+    _pressure = pressure;
+    _humidity = humidity;
+    _cached = 0;
+}
+
+/**
+ * Sets a new sample from the fields of BME680#getFieldData and drops the cached values
+ * @param data Compensated field data
+ */
+void BME680DerivedMetrics::update(const struct bme680_field_data &data) {
+    update(data.temperature, data.pressure, data.humidity);
+}
+
+/**
+ * Get the partial pressure of water vapour
+ * @return Vapour pressure in deci Pascal
+ */
+uint32_t BME680DerivedMetrics::getVapourPressure() {
+    if (!(_cached & CACHED_VAPOUR_PRESSURE)) {
+        int32_t offset = (int32_t) _temperature - SVP_MIN_TEMP;
+        uint32_t index, fraction, saturation;
+
+        if (offset < 0)
+            offset = 0;
+        if (offset > (SVP_LEN - 1) * SVP_STEP)
+            offset = (SVP_LEN - 1) * SVP_STEP;
+
+        index = offset / SVP_STEP;
+        fraction = offset % SVP_STEP;
+
+        if (index == SVP_LEN - 1) {
+            index--;
+            fraction = SVP_STEP;
+        }
+
+        saturation = svpTable[index] + (svpTable[index + 1] - svpTable[index]) * fraction / SVP_STEP;
+        _vapourPressure = (uint32_t) ((uint64_t) saturation * _humidity / 100000);
+        _cached |= CACHED_VAPOUR_PRESSURE;
+    }
+
+    return _vapourPressure;
+}
+
+/**
+ * Get the dew point, by reverse lookup of the vapour pressure in the saturation table
+ * @return Dew point in centi degree celsius
+ */
+int16_t BME680DerivedMetrics::getDewPoint() {
+    if (!(_cached & CACHED_DEW_POINT)) {
+        uint32_t vapour = getVapourPressure();
+        uint32_t low = 0, high = SVP_LEN - 1;
+
+        if (vapour <= svpTable[0]) {
+            _dewPoint = SVP_MIN_TEMP;
+        } else if (vapour >= svpTable[SVP_LEN - 1]) {
+            _dewPoint = SVP_MIN_TEMP + (SVP_LEN - 1) * SVP_STEP;
+        } else {
+            /* Binary search of the surrounding table entries */
+            while (high - low > 1) {
+                uint32_t middle = (low + high) / 2;
+
+                if (svpTable[middle] <= vapour)
+                    low = middle;
+                else
+                    high = middle;
+            }
+
+            _dewPoint = (int16_t) (SVP_MIN_TEMP + (int32_t) low * SVP_STEP
+                                   + (int32_t) ((vapour - svpTable[low]) * SVP_STEP / (svpTable[high] - svpTable[low])));
+        }
+
+        _cached |= CACHED_DEW_POINT;
+    }
+
+    return _dewPoint;
+}
+
+/**
+ * Get the mass of water vapour per volume of air
+ * @return Absolute humidity in mg/m3
+ */
+uint32_t BME680DerivedMetrics::getAbsoluteHumidity() {
+    if (!(_cached & CACHED_ABSOLUTE_HUMIDITY)) {
+        /* rho = e * M_w / (R * T) = 2.16679 g K / J * e / T */
+        _absoluteHumidity = (uint32_t) ((uint64_t) getVapourPressure() * 216679
+                                        / (10 * (uint32_t) ((int32_t) _temperature + 27315)));
+        _cached |= CACHED_ABSOLUTE_HUMIDITY;
+    }
+
+    return _absoluteHumidity;
+}
+
+/**
+ * Get the barometric altitude relative to the sea level pressure
+ * @return Altitude in cm
+ */
+int32_t BME680DerivedMetrics::getAltitude() {
+    if (!(_cached & CACHED_ALTITUDE)) {
+        uint32_t ratio = (uint32_t) (((uint64_t) _pressure << 16) / _seaLevelPressure);
+        uint32_t offset, index, fraction;
+
+        if (ratio < ALT_MIN_RATIO)
+            ratio = ALT_MIN_RATIO;
+
+        offset = ratio - ALT_MIN_RATIO;
+        index = offset >> ALT_STEP_BITS;
+        fraction = offset & ((1 << ALT_STEP_BITS) - 1);
+
+        if (index >= ALT_LEN - 1) {
+            index = ALT_LEN - 2;
+            fraction = 1 << ALT_STEP_BITS;
+        }
+
+        _altitude = altitudeTable[index]
+                    + (int32_t) (((int64_t) (altitudeTable[index + 1] - altitudeTable[index]) * fraction) >> ALT_STEP_BITS);
+        _cached |= CACHED_ALTITUDE;
+    }
+
+    return _altitude;
+}
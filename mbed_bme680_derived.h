@@ -0,0 +1,46 @@
+#ifndef BME680_DERIVED_H
+#define BME680_DERIVED_H
+
+#include "bme680.h"
+
+#define BME680_SEA_LEVEL_PRESSURE 101325  // Standard atmosphere in Pascal
+
+/**
+ * Dew point, absolute humidity and barometric altitude from one compensated sample.
+ * Values are computed on first request and cached until the next BME680DerivedMetrics#update.
+ * Only integer arithmetic and table interpolation is used, no libm calls.
+ *
+ * Error bounds against the underlying formulas (Magnus with 17.62 / 243.12 degC, international barometric formula):
+ * - Vapour pressure and absolute humidity: < 0.8 % for -40 to 85 degC
+ * - Dew point: < 0.1 degC for dew points of -40 to 85 degC, clamped to that range
+ * - Altitude: < 0.5 m for 800 to 1100 hPa, < 2.2 m for 300 to 1100 hPa (with the standard sea level pressure)
+ */
+class BME680DerivedMetrics {
+public:
+    BME680DerivedMetrics();
+
+    void setSeaLevelPressure(uint32_t pressure);
+
+    void update(int16_t temperature, uint32_t pressure, uint32_t humidity);
+
+    void update(const struct bme680_field_data &data);
+
+    uint32_t getVapourPressure();
+
+    int16_t getDewPoint();
+
+    uint32_t getAbsoluteHumidity();
+
+    int32_t getAltitude();
+
+private:
+    int16_t _temperature;
+    uint32_t _pressure, _humidity, _seaLevelPressure;
+    uint8_t _cached;  // Bit mask of the valid cached values
+    uint32_t _vapourPressure;  // Deci Pascal
+    int16_t _dewPoint;
+    uint32_t _absoluteHumidity;
+    int32_t _altitude;
+};
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef BME680_FILTER_H
+#define BME680_FILTER_H
+
+#include "bme680.h"
+
+/*
+ * Fixed memory integer filters for post-processing readings on the MCU.
+ * Every stage has the same interface: update() takes a value and returns False while it has no output
+ * (e.g. a decimator between two outputs), reset() forgets the history. Stages are combined per channel
+ * with BME680FilterChain, the channels of a reading with BME680FilterPipeline.
+ */
+
+/**
+ * Passes the values through unchanged.
+ */
+class BME680NoFilter {
+public:
+    void reset() {}
+
+    bool update(int32_t in, int32_t *out) {
+        *out = in;
+        return true;
+    }
+};
+
+/**
+ * Median of the last N values, removes single sample spikes.
+ * Keeps the window sorted, each update moves at most N values.
+ * @tparam N Window length, odd
+ */
+template<uint8_t N>
+class BME680MedianFilter {
+    static_assert(N > 0 && (N & 1) == 1, "BME680MedianFilter window length must be odd");
+
+public:
+    BME680MedianFilter() {
+        reset();
+    }
+
+    void reset() {
+        _count = 0;
+        _oldest = 0;
+    }
+
+    /**
+     * @param in New value
+     * @param out Receives the median of the window, of the values seen so far while it fills
+     * @return Always True
+     */
+    bool update(int32_t in, int32_t *out) {
+        uint8_t pos;
+
+        if (_count < N) {
+            _window[_count] = in;
+            pos = _count++;
+        } else {
+            /* Replace the oldest value in the sorted window */
+            int32_t old = _window[_oldest];
+            _window[_oldest] = in;
+            _oldest = (_oldest + 1) % N;
+
+            for (pos = 0; _sorted[pos] != old; pos++) {}
+        }
+
+        /* Move the new value to its place */
+        while (pos > 0 && _sorted[pos - 1] > in) {
+            _sorted[pos] = _sorted[pos - 1];
+            pos--;
+        }
+        while (pos + 1 < _count && _sorted[pos + 1] < in) {
+            _sorted[pos] = _sorted[pos + 1];
+            pos++;
+        }
+        _sorted[pos] = in;
+
+        *out = _sorted[(_count - 1) / 2];
+        return true;
+    }
+
+private:
+    int32_t _window[N];  // Values in arrival order
+    int32_t _sorted[N];
+    uint8_t _count, _oldest;
+};
+
+/**
+ * Exponential moving average, each value moves the output by 1 / 2^Shift of the difference.
+ * The state keeps FracBits extra bits so small steps are not lost. The first value initializes the state.
+ * @tparam Shift Smoothing, 1 to 16
+ * @tparam FracBits Fraction bits of the state
+ */
+template<uint8_t Shift, uint8_t FracBits = 4>
+class BME680EMAFilter {
+    static_assert(Shift >= 1 && Shift <= 16, "BME680EMAFilter shift must be 1 to 16");
+
+public:
+    BME680EMAFilter() {
+        reset();
+    }
+
+    void reset() {
+        _primed = false;
+    }
+
+    bool update(int32_t in, int32_t *out) {
+        int64_t scaled = (int64_t) in << FracBits;
+
+        if (!_primed) {
+            _state = scaled;
+            _primed = true;
+        } else {
+            _state += (scaled - _state) / (1 << Shift);
+        }
+
+        *out = (int32_t) ((_state + (1 << FracBits >> 1)) >> FracBits);
+        return true;
+    }
+
+private:
+    int64_t _state;
+    bool _primed;
+};
+
+/**
+ * Outputs the average of every N values, reducing the rate by N.
+ * @tparam N Decimation factor
+ */
+template<uint16_t N>
+class BME680Decimator {
+    static_assert(N > 0, "BME680Decimator factor must not be 0");
+
+public:
+    BME680Decimator() {
+        reset();
+    }
+
+    void reset() {
+        _sum = 0;
+        _count = 0;
+    }
+
+    /**
+     * @param in New value
+     * @param out Receives the average of the last N values
+     * @return True every N-th value, False otherwise
+     */
+    bool update(int32_t in, int32_t *out) {
+        _sum += in;
+
+        if (++_count < N)
+            return false;
+
+        *out = (int32_t) (_sum / N);
+        _sum = 0;
+        _count = 0;
+        return true;
+    }
+
+private:
+    int64_t _sum;
+    uint16_t _count;
+};
+
+/**
+ * Runs the stages one after the other, a stage without output ends the update.
+ * e.g. BME680FilterChain<BME680MedianFilter<3>, BME680EMAFilter<2>> removes spikes and then smooths.
+ * @tparam Stages Filter stages in processing order
+ */
+template<typename... Stages>
+class BME680FilterChain;
+
+template<>
+class BME680FilterChain<> {
+public:
+    void reset() {}
+
+    bool update(int32_t in, int32_t *out) {
+        *out = in;
+        return true;
+    }
+};
+
+template<typename First, typename... Rest>
+class BME680FilterChain<First, Rest...> {
+public:
+    void reset() {
+        _first.reset();
+        _rest.reset();
+    }
+
+    bool update(int32_t in, int32_t *out) {
+        int32_t value;
+
+        if (!_first.update(in, &value))
+            return false;
+
+        return _rest.update(value, out);
+    }
+
+private:
+    First _first;
+    BME680FilterChain<Rest...> _rest;
+};
+
+/**
+ * One filter chain per channel of a reading.
+ * Gas resistance is only filtered with valid and stable gas readings, others keep the last output.
+ * @tparam Temperature Chain for the temperature in centi degree Celsius
+ * @tparam Pressure Chain for the pressure in Pascal
+ * @tparam Humidity Chain for the humidity in milli % relative humidity
+ * @tparam Gas Chain for the gas resistance in Ohm
+ */
+template<typename Temperature, typename Pressure = BME680NoFilter, typename Humidity = BME680NoFilter,
+        typename Gas = BME680NoFilter>
+class BME680FilterPipeline {
+public:
+    BME680FilterPipeline() {
+        reset();
+    }
+
+    void reset() {
+        _temperature.reset();
+        _pressure.reset();
+        _humidity.reset();
+        _gas.reset();
+        _output = bme680_field_data();
+    }
+
+    /**
+     * Filters a reading, e.g. BME680#getFieldData after BME680#performReading
+     * @param in Compensated field data
+     * @return True if temperature, pressure and humidity have a new output, False otherwise
+     */
+    bool update(const struct bme680_field_data &in) {
+        int32_t value;
+        bool tph = true;
+
+        if (_temperature.update(in.temperature, &value))
+            _output.temperature = (int16_t) value;
+        else
+            tph = false;
+
+        if (_pressure.update((int32_t) in.pressure, &value))
+            _output.pressure = (uint32_t) value;
+        else
+            tph = false;
+
+        if (_humidity.update((int32_t) in.humidity, &value))
+            _output.humidity = (uint32_t) value;
+        else
+            tph = false;
+
+        if ((in.status & BME680_GASM_VALID_MSK) && (in.status & BME680_HEAT_STAB_MSK)
+            && _gas.update((int32_t) in.gas_resistance, &value))
+            _output.gas_resistance = (uint32_t) value;
+
+        _output.status = in.status;
+        _output.gas_index = in.gas_index;
+        _output.meas_index = in.meas_index;
+
+        return tph;
+    }
+
+    /**
+     * @return Latest output of every channel, with the status of the last input
+     */
+    const struct bme680_field_data &getOutput() const {
+        return _output;
+    }
+
+private:
+    Temperature _temperature;
+    Pressure _pressure;
+    Humidity _humidity;
+    Gas _gas;
+    struct bme680_field_data _output;
+};
+
+#endif
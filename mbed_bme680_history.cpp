@@ -0,0 +1,158 @@
+#include "mbed_bme680_history.h"
+
+#include "bme680.h"
+
+/**
+ * Converts a sample into the compact form, out of range values are saturated
+ * @param record Sample in raw getter units
+ * @return Compact values
+ */
+BME680HistoryValues BME680HistoryValues::encode(const BME680Record &record) {
+    BME680HistoryValues values;
+    uint32_t pressure = (record.pressure + 1) / 2;
+    uint32_t humidity = (record.humidity + 5) / 10;
+
+    values.temperature = record.temperature;
+    values.pressure = (uint16_t) (pressure > UINT16_MAX ? UINT16_MAX : pressure);
+    values.humidity = (uint16_t) (humidity > UINT16_MAX ? UINT16_MAX : humidity);
+
+    if ((record.status & BME680_GASM_VALID_MSK) && (record.status & BME680_HEAT_STAB_MSK))
+        values.gas = encodeGas(record.gasResistance);
+    else
+        values.gas = 0;
+
+    return values;
+}
+
+/**
+ * @param gasResistance Gas resistance in Ohm
+ * @return 12 bit mantissa with 4 bit exponent, at least 1 so the value does not read as missing
+ */
+uint16_t BME680HistoryValues::encodeGas(uint32_t gasResistance) {
+    uint8_t exponent = 0;
+
+    while (gasResistance > 0xFFF) {
+        if (exponent == 15)
+            return 0xFFFF;
+
+        /* Round to nearest when dropping the last bit, without overflowing at UINT32_MAX */
+        gasResistance = (gasResistance >> 1) + (gasResistance & 1);
+        exponent++;
+    }
+
+    if (gasResistance == 0)
+        gasResistance = 1;
+
+    return (uint16_t) ((exponent << 12) | gasResistance);
+}
+
+/**
+ * @return Temperature in centi degree Celsius
+ */
+int16_t BME680HistoryValues::getTemperature() const {
+    return temperature;
+}
+
+/**
+ * @return Pressure in Pascal
+ */
+uint32_t BME680HistoryValues::getPressure() const {
+    return (uint32_t) pressure * 2;
+}
+
+/**
+ * @return Humidity in milli % relative humidity
+ */
+uint32_t BME680HistoryValues::getHumidity() const {
+    return (uint32_t) humidity * 10;
+}
+
+/**
+ * @return Gas resistance in Ohm, 0 without a stable gas reading
+ */
+uint32_t BME680HistoryValues::getGasResistance() const {
+    return (uint32_t) (gas & 0xFFF) << (gas >> 12);
+}
+
+BME680HistoryAccumulator::BME680HistoryAccumulator() {
+    reset(0);
+}
+
+/**
+ * Starts a new bucket
+ * @param start Start of the period in milliseconds
+ */
+void BME680HistoryAccumulator::reset(uint32_t start) {
+    _start = start;
+    _count = _gasCount = 0;
+    _temperature = 0;
+    _pressure = _humidity = _gas = 0;
+    _min = _max = BME680HistoryValues();
+}
+
+/**
+ * Adds a sample to the bucket, samples beyond UINT16_MAX are ignored
+ * @param values Compact values of the sample
+ */
+void BME680HistoryAccumulator::add(const BME680HistoryValues &values) {
+    if (_count == UINT16_MAX)
+        return;
+
+    if (_count == 0) {
+        _min = _max = values;
+    } else {
+        if (values.temperature < _min.temperature) _min.temperature = values.temperature;
+        if (values.temperature > _max.temperature) _max.temperature = values.temperature;
+        if (values.pressure < _min.pressure) _min.pressure = values.pressure;
+        if (values.pressure > _max.pressure) _max.pressure = values.pressure;
+        if (values.humidity < _min.humidity) _min.humidity = values.humidity;
+        if (values.humidity > _max.humidity) _max.humidity = values.humidity;
+    }
+
+    _count++;
+    _temperature += values.temperature;
+    _pressure += values.pressure;
+    _humidity += values.humidity;
+
+    /* The mantissa/exponent form keeps its order, so min and max work on the codes */
+    if (values.gas != 0) {
+        if (_gasCount == 0 || values.gas < _min.gas) _min.gas = values.gas;
+        if (_gasCount == 0 || values.gas > _max.gas) _max.gas = values.gas;
+
+        _gasCount++;
+        _gas += values.getGasResistance();
+    }
+}
+
+bool BME680HistoryAccumulator::empty() const {
+    return _count == 0;
+}
+
+uint32_t BME680HistoryAccumulator::start() const {
+    return _start;
+}
+
+/**
+ * @return Statistics of the samples added since the last BME680HistoryAccumulator#reset
+ */
+BME680HistoryBucket BME680HistoryAccumulator::bucket() const {
+    BME680HistoryBucket bucket;
+
+    bucket.start = _start;
+    bucket.count = _count;
+    bucket.gasCount = _gasCount;
+    bucket.min = _min;
+    bucket.max = _max;
+
+    if (_count == 0) {
+        bucket.mean = BME680HistoryValues();
+        return bucket;
+    }
+
+    bucket.mean.temperature = (int16_t) ((_temperature + (_temperature >= 0 ? _count / 2 : -(_count / 2))) / _count);
+    bucket.mean.pressure = (uint16_t) ((_pressure + _count / 2) / _count);
+    bucket.mean.humidity = (uint16_t) ((_humidity + _count / 2) / _count);
+    bucket.mean.gas = _gasCount > 0 ? BME680HistoryValues::encodeGas((uint32_t) ((_gas + _gasCount / 2) / _gasCount)) : 0;
+
+    return bucket;
+}
@@ -0,0 +1,268 @@
+#ifndef BME680_HISTORY_H
+#define BME680_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mbed_bme680_record.h"
+
+/*
+ * Multi-resolution sample history in fixed memory.
+ * Raw samples are kept for the last RawSize readings, 1 minute and 10 minute min/mean/max buckets
+ * for the last MinuteSize and TenMinuteSize periods. Each value is stored in 16 bits.
+ * This file has no Mbed dependency so the history can also be replayed on the host.
+ */
+
+#define BME680_HISTORY_MINUTE 60000UL  // Bucket lengths in milliseconds
+#define BME680_HISTORY_TEN_MINUTES 600000UL
+
+/**
+ * Compact values of one sample: centi degree Celsius, 2 Pascal steps, centi % relative humidity
+ * and the gas resistance as 12 bit mantissa with 4 bit exponent (Ohm = mantissa << exponent).
+ * A gas value of 0 means no stable gas reading.
+ */
+struct BME680HistoryValues {
+    int16_t temperature;
+    uint16_t pressure;
+    uint16_t humidity;
+    uint16_t gas;
+
+    static BME680HistoryValues encode(const BME680Record &record);
+
+    static uint16_t encodeGas(uint32_t gasResistance);
+
+    int16_t getTemperature() const;
+
+    uint32_t getPressure() const;
+
+    uint32_t getHumidity() const;
+
+    uint32_t getGasResistance() const;
+};
+
+/**
+ * Raw sample of the history.
+ */
+struct BME680HistorySample {
+    uint32_t timestamp;  // Milliseconds, as passed to BME680History#add
+    BME680HistoryValues values;
+};
+
+/**
+ * Aggregated samples of one period.
+ */
+struct BME680HistoryBucket {
+    uint32_t start;  // Start of the period in milliseconds, a multiple of the bucket length
+    uint16_t count;  // Samples in the bucket
+    uint16_t gasCount;  // Samples with a stable gas reading, the gas statistics only cover them
+    BME680HistoryValues min, mean, max;
+};
+
+/**
+ * Collects the samples of the bucket in progress.
+ */
+class BME680HistoryAccumulator {
+public:
+    BME680HistoryAccumulator();
+
+    void reset(uint32_t start);
+
+    void add(const BME680HistoryValues &values);
+
+    bool empty() const;
+
+    uint32_t start() const;
+
+    BME680HistoryBucket bucket() const;
+
+private:
+    uint32_t _start;
+    uint16_t _count, _gasCount;
+    int64_t _temperature;
+    uint64_t _pressure, _humidity, _gas;
+    BME680HistoryValues _min, _max;
+};
+
+/**
+ * Fixed size ring that overwrites its oldest item, with binary search on the item time.
+ * Item times must increase, the span of the ring must stay below 2^31 milliseconds.
+ */
+template<typename T, uint16_t N>
+class BME680HistoryRing {
+    static_assert(N > 0, "BME680HistoryRing size must not be 0");
+
+public:
+    BME680HistoryRing() : _first(0), _count(0) {}
+
+    void push(const T &item) {
+        if (_count < N) {
+            _items[(_first + _count) % N] = item;
+            _count++;
+        } else {
+            _items[_first] = item;
+            _first = (_first + 1) % N;
+        }
+    }
+
+    uint16_t size() const {
+        return _count;
+    }
+
+    /**
+     * @param index 0 for the oldest item
+     */
+    const T &at(uint16_t index) const {
+        return _items[(_first + index) % N];
+    }
+
+    /**
+     * Copies the items with from <= time < to, oldest first.
+     * Times are compared relative to the oldest item, so the range may cross the wrap of the millisecond time.
+     * A from before the oldest item starts with the oldest item, unless to lies before it as well.
+     * A to outside the stored items ends after the newest item, e.g. query(0, UINT32_MAX, ...) copies all items
+     * unless the stored items cross the wrap, then both bounds lie within them in reverse order.
+     * @param from Start of the range in milliseconds
+     * @param to End of the range in milliseconds, exclusive
+     * @param out Receives the items
+     * @param max Size of out
+     * @return Number of copied items
+     */
+    uint16_t query(uint32_t from, uint32_t to, T *out, uint16_t max) const {
+        uint16_t low = 0, high = _count, copied = 0;
+
+        if (_count == 0)
+            return 0;
+
+        /* Times relative to the oldest item to handle the wrap around */
+        uint32_t oldest = time(at(0));
+        uint32_t span = time(at(_count - 1)) - oldest;
+        uint32_t begin = from - oldest, end = to - oldest;
+
+        if (begin > INT32_MAX) {
+            if (to - from <= oldest - from)
+                return 0;
+
+            begin = 0;
+        }
+
+        if (end > span)
+            end = span + 1;
+
+        /* First item at or after from */
+        while (low < high) {
+            uint16_t mid = (low + high) / 2;
+
+            if (time(at(mid)) - oldest < begin)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        for (uint16_t i = low; i < _count && copied < max && time(at(i)) - oldest < end; i++)
+            out[copied++] = at(i);
+
+        return copied;
+    }
+
+private:
+    T _items[N];
+    uint16_t _first, _count;
+
+    static uint32_t time(const BME680HistorySample &sample) {
+        return sample.timestamp;
+    }
+
+    static uint32_t time(const BME680HistoryBucket &bucket) {
+        return bucket.start;
+    }
+};
+
+/**
+ * Sample history with raw, 1 minute and 10 minute tiers, fed downstream of BME680#performReading.
+ * Inserting a sample updates all tiers in constant time; queries binary search the tier.
+ * e.g. BME680History<100, 60, 6> keeps 100 samples and one hour of buckets in 3440 bytes.
+ * Bucket starts are multiples of the bucket length in the millisecond time, which wraps after about 49.7 days.
+ * 2^32 is not a multiple of the bucket lengths, so the buckets around the wrap are shorter and the starts
+ * after it are offset against the ones before.
+ * @tparam RawSize Number of raw samples
+ * @tparam MinuteSize Number of 1 minute buckets
+ * @tparam TenMinuteSize Number of 10 minute buckets
+ */
+template<uint16_t RawSize, uint16_t MinuteSize, uint16_t TenMinuteSize>
+class BME680History {
+public:
+    /**
+     * Adds a sample
+     * @param record Sample values and time in milliseconds, the time must not go backwards
+     */
+    void add(const BME680Record &record) {
+        BME680HistorySample sample;
+
+        sample.timestamp = record.timestamp;
+        sample.values = BME680HistoryValues::encode(record);
+        _raw.push(sample);
+
+        roll(_minute, _minutes, record.timestamp, BME680_HISTORY_MINUTE);
+        roll(_tenMinute, _tenMinutes, record.timestamp, BME680_HISTORY_TEN_MINUTES);
+        _minute.add(sample.values);
+        _tenMinute.add(sample.values);
+    }
+
+    /**
+     * Copies the raw samples in the range, oldest first, see BME680HistoryRing#query for the range
+     * @return Number of copied samples
+     */
+    uint16_t getSamples(uint32_t from, uint32_t to, BME680HistorySample *out, uint16_t max) const {
+        return _raw.query(from, to, out, max);
+    }
+
+    /**
+     * Copies the completed 1 minute buckets starting in the range, oldest first
+     * @return Number of copied buckets
+     */
+    uint16_t getMinuteBuckets(uint32_t from, uint32_t to, BME680HistoryBucket *out, uint16_t max) const {
+        return _minutes.query(from, to, out, max);
+    }
+
+    /**
+     * Copies the completed 10 minute buckets starting in the range, oldest first
+     * @return Number of copied buckets
+     */
+    uint16_t getTenMinuteBuckets(uint32_t from, uint32_t to, BME680HistoryBucket *out, uint16_t max) const {
+        return _tenMinutes.query(from, to, out, max);
+    }
+
+    /**
+     * Get the 1 minute bucket in progress
+     * @param bucket Receives the bucket
+     * @return True on success, False if no sample was added yet
+     */
+    bool getCurrentMinute(BME680HistoryBucket *bucket) const {
+        if (_minute.empty())
+            return false;
+
+        *bucket = _minute.bucket();
+        return true;
+    }
+
+private:
+    BME680HistoryRing<BME680HistorySample, RawSize> _raw;
+    BME680HistoryRing<BME680HistoryBucket, MinuteSize> _minutes;
+    BME680HistoryRing<BME680HistoryBucket, TenMinuteSize> _tenMinutes;
+    BME680HistoryAccumulator _minute, _tenMinute;
+
+    template<typename Ring>
+    static void roll(BME680HistoryAccumulator &current, Ring &ring, uint32_t timestamp, uint32_t length) {
+        uint32_t start = timestamp - timestamp % length;
+
+        if (!current.empty() && current.start() == start)
+            return;
+
+        if (!current.empty())
+            ring.push(current.bucket());
+
+        current.reset(start);
+    }
+};
+
+#endif
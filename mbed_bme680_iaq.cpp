@@ -0,0 +1,234 @@
+#include "mbed_bme680_iaq.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define BASELINE_FRACTION_BITS 8
+#define SLOW_DOWN_BITS 4  // Falling resistance moves the baseline 16 times slower
+#define HUMIDITY_FACTOR_MIN 250000UL  // Humidity correction limits in millionths, 1/4 to 4
+#define HUMIDITY_FACTOR_MAX 4000000UL
+
+BME680IAQ::BME680IAQ() {
+    _shift = 6;
+    _burnIn = 50;
+    _humReference = 40000;
+    _humWeight = 25;
+    _humSlope = 40;
+    reset();
+}
+
+/**
+ * Forgets the learned baseline
+ */
+void BME680IAQ::reset() {
+    _samples = 0;
+    _baseline = 0;
+    _deviation = 0;
+    _iaq = 0;
+}
+
+/**
+ * Setter for the baseline adaption speed after the burn-in
+ * @param shift Each sample moves the baseline by 1 / 2^shift of the difference, 1 to 16
+ */
+void BME680IAQ::setBaselineSpeed(uint8_t shift) {
+    if (shift < 1)
+        shift = 1;
+    if (shift > 16)
+        shift = 16;
+
+    _shift = shift;
+}
+
+/**
+ * Setter for the burn-in, during which the baseline is the plain average of the samples
+ * @param samples Number of samples before the index is considered calibrated
+ */
+void BME680IAQ::setBurnIn(uint32_t samples) {
+    _burnIn = samples;
+}
+
+/**
+ * Setter for the humidity share of the index
+ * @param humidity Optimal humidity in milli % relative humidity, the gas resistance is corrected to it
+ * @param weight Share of the humidity in the index in percent, 0 to 100
+ */
+void BME680IAQ::setHumidityReference(uint32_t humidity, uint8_t weight) {
+    if (humidity < 1000)
+        humidity = 1000;
+    if (humidity > 99000)
+        humidity = 99000;
+
+    _humReference = humidity;
+    _humWeight = weight > 100 ? 100 : weight;
+}
+
+/**
+ * Setter for the humidity correction of the gas resistance.
+ * The resistance is scaled linearly by the humidity distance to the humidity reference, see
+ * BME680IAQ#setHumidityReference, the correction factor is limited to 1/4 to 4.
+ * @param slope Resistance change per % relative humidity in tenths of a percent, 0 for no correction
+ */
+void BME680IAQ::setHumidityCompensation(uint16_t slope) {
+    _humSlope = slope;
+}
+
+/**
+ * Updates the baseline and the index with a sample
+ * @param data Compensated field data
+ * @return True if the sample had a valid and stable gas reading and was used, False otherwise
+ */
+bool BME680IAQ::update(const struct bme680_field_data &data) {
+    if (!(data.status & BME680_GASM_VALID_MSK) || !(data.status & BME680_HEAT_STAB_MSK) || data.gas_resistance == 0)
+        return false;
+
+    uint32_t gas = compensateHumidity(data.gas_resistance, data.humidity);
+
+    track(gas);
+    _iaq = score(gas, data.humidity);
+
+    return true;
+}
+
+/**
+ * @return Index of the last sample, 0 (good) to 500 (bad)
+ */
+uint16_t BME680IAQ::getIAQ() {
+    return _iaq;
+}
+
+/**
+ * @return True once the burn-in is over
+ */
+bool BME680IAQ::isCalibrated() {
+    return _samples >= _burnIn;
+}
+
+/**
+ * @return Clean air gas resistance baseline in Ohm
+ */
+uint32_t BME680IAQ::getBaseline() {
+    return (uint32_t) (_baseline >> BASELINE_FRACTION_BITS);
+}
+
+/**
+ * @return Mean absolute deviation of the gas resistance from the baseline in Ohm
+ */
+uint32_t BME680IAQ::getDeviation() {
+    return _deviation;
+}
+
+/**
+ * Captures the learned baseline, to be restored with BME680IAQ#importState after a reboot
+ * @param state Receives the state
+ */
+void BME680IAQ::exportState(BME680IAQState *state) {
+    memset(state, 0, sizeof(*state));
+    state->version = BME680_IAQ_STATE_VERSION;
+    state->samples = _samples;
+    state->baseline = _baseline;
+    state->deviation = _deviation;
+    state->checksum = stateChecksum(*state);
+}
+
+/**
+ * Restores a baseline captured with BME680IAQ#exportState
+ * @param state Stored state
+ * @return True on success, False if the state is not valid or from another version
+ */
+bool BME680IAQ::importState(const BME680IAQState &state) {
+    if ((state.version != BME680_IAQ_STATE_VERSION) || (state.checksum != stateChecksum(state))
+        || (state.samples > 0 && state.baseline == 0))
+        return false;
+
+    _samples = state.samples;
+    _baseline = state.baseline;
+    _deviation = state.deviation;
+
+    return true;
+}
+
+uint32_t BME680IAQ::compensateHumidity(uint32_t gas, uint32_t humidity) {
+    /* Milli %RH times tenths of a percent per %RH gives millionths */
+    int64_t factor = 1000000 + ((int64_t) humidity - _humReference) * _humSlope;
+
+    if (factor < (int64_t) HUMIDITY_FACTOR_MIN)
+        factor = HUMIDITY_FACTOR_MIN;
+    if (factor > (int64_t) HUMIDITY_FACTOR_MAX)
+        factor = HUMIDITY_FACTOR_MAX;
+
+    uint64_t compensated = (uint64_t) gas * (uint64_t) factor / 1000000;
+
+    return compensated > UINT32_MAX ? UINT32_MAX : (uint32_t) compensated;
+}
+
+void BME680IAQ::track(uint32_t gas) {
+    uint64_t scaled = (uint64_t) gas << BASELINE_FRACTION_BITS;
+    uint32_t baseline = getBaseline();
+    uint32_t difference = gas > baseline ? gas - baseline : baseline - gas;
+    uint8_t shift;
+
+    if (_samples < UINT32_MAX)
+        _samples++;
+
+    if (_samples <= _burnIn) {
+        /* Cumulative average while burning in */
+        if (scaled >= _baseline)
+            _baseline += (scaled - _baseline) / _samples;
+        else
+            _baseline -= (_baseline - scaled) / _samples;
+
+        _deviation = (uint32_t) (((uint64_t) _deviation * (_samples - 1) + difference) / _samples);
+        return;
+    }
+
+    shift = _shift;
+
+    if (scaled >= _baseline) {
+        _baseline += (scaled - _baseline) >> shift;
+    } else {
+        _baseline -= (_baseline - scaled) >> (shift + SLOW_DOWN_BITS);
+    }
+
+    if (difference >= _deviation)
+        _deviation += (difference - _deviation) >> shift;
+    else
+        _deviation -= (_deviation - difference) >> shift;
+}
+
+uint16_t BME680IAQ::score(uint32_t gas, uint32_t humidity) {
+    uint32_t baseline = getBaseline();
+    uint32_t humScore, gasScore, gasWeight = 100 - _humWeight;
+
+    /* Scores in hundredths of a percent of air quality, 10000 is best */
+    if (humidity > _humReference) {
+        uint32_t offset = humidity - _humReference;
+        uint32_t range = 100000 - _humReference;
+
+        humScore = offset >= range ? 0 : (uint32_t) ((uint64_t) (range - offset) * _humWeight * 100 / range);
+    } else {
+        humScore = (uint32_t) ((uint64_t) humidity * _humWeight * 100 / _humReference);
+    }
+
+    if (baseline == 0 || gas >= baseline)
+        gasScore = gasWeight * 100;
+    else
+        gasScore = (uint32_t) ((uint64_t) gas * gasWeight * 100 / baseline);
+
+    return (uint16_t) ((10000 - (humScore + gasScore)) * 5 / 100);
+}
+
+/**
+ * FNV-1a hash of the state, without the checksum field
+ */
+uint32_t BME680IAQ::stateChecksum(const BME680IAQState &state) {
+    const uint8_t *bytes = (const uint8_t *) &state;
+    uint32_t hash = 2166136261UL;
+
+    for (size_t i = 0; i < offsetof(BME680IAQState, checksum); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
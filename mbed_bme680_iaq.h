@@ -0,0 +1,77 @@
+#ifndef BME680_IAQ_H
+#define BME680_IAQ_H
+
+#include "bme680.h"
+
+#define BME680_IAQ_STATE_VERSION 2
+
+/**
+ * Learned gas baseline of a BME680IAQ, to be persisted across reboots.
+ */
+struct BME680IAQState {
+    uint8_t version;
+    uint32_t samples;
+    uint64_t baseline;   // Gas resistance in Ohm, scaled by 256
+    uint32_t deviation;  // Mean absolute deviation from the baseline in Ohm
+    uint32_t checksum;   // FNV-1a of the fields above
+};
+
+/**
+ * Indoor air quality index from gas resistance and humidity.
+ * Tracks a clean air gas resistance baseline with exponential moving statistics (O(1) memory);
+ * the baseline follows rising resistance quickly and falling resistance slowly, so pollution events
+ * don't drag it down. Each sample costs a constant amount of integer arithmetic.
+ * The gas resistance drops with rising humidity, so it is corrected to the humidity reference before
+ * it enters the baseline and the index.
+ * The index ranges from 0 (good) to 500 (bad): the gas share scores the corrected resistance relative to
+ * the baseline, the humidity share the distance to the humidity reference.
+ */
+class BME680IAQ {
+public:
+    BME680IAQ();
+
+    void reset();
+
+    void setBaselineSpeed(uint8_t shift);
+
+    void setBurnIn(uint32_t samples);
+
+    void setHumidityReference(uint32_t humidity, uint8_t weight);
+
+    void setHumidityCompensation(uint16_t slope);
+
+    bool update(const struct bme680_field_data &data);
+
+    uint16_t getIAQ();
+
+    bool isCalibrated();
+
+    uint32_t getBaseline();
+
+    uint32_t getDeviation();
+
+    void exportState(BME680IAQState *state);
+
+    bool importState(const BME680IAQState &state);
+
+private:
+    uint8_t _shift;
+    uint32_t _burnIn;
+    uint32_t _humReference;
+    uint8_t _humWeight;
+    uint16_t _humSlope;
+    uint32_t _samples;
+    uint64_t _baseline;
+    uint32_t _deviation;
+    uint16_t _iaq;
+
+    uint32_t compensateHumidity(uint32_t gas, uint32_t humidity);
+
+    void track(uint32_t gas);
+
+    uint16_t score(uint32_t gas, uint32_t humidity);
+
+    static uint32_t stateChecksum(const BME680IAQState &state);
+};
+
+#endif
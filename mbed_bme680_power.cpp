@@ -0,0 +1,199 @@
+#include "mbed_bme680_power.h"
+#include "mbed_bme680_thresholds.h"
+
+/* Measurement cycles per oversampling setting, 0 for invalid settings BME680#set*Oversampling rejects */
+static uint8_t measCycles(uint8_t os) {
+    return os <= BME680_OS_16X && os > BME680_OS_NONE ? 1 << (os - 1) : 0;
+}
+
+BME680PowerManager::BME680PowerManager(BME680 &sensor) : _sensor(sensor) {
+    /* High fidelity matches the BME680#begin defaults */
+    _high.osTemperature = BME680_OS_8X;
+    _high.osPressure = BME680_OS_4X;
+    _high.osHumidity = BME680_OS_2X;
+    _high.filter = BME680_FILTER_SIZE_3;
+    _high.gas = true;
+
+    _low.osTemperature = BME680_OS_1X;
+    _low.osPressure = BME680_OS_1X;
+    _low.osHumidity = BME680_OS_1X;
+    _low.filter = BME680_FILTER_SIZE_3;
+    _low.gas = false;
+
+    _tempThreshold = BME680_DEFAULT_TEMP_THRESHOLD;
+    _presThreshold = BME680_DEFAULT_PRES_THRESHOLD;
+    _humThreshold = BME680_DEFAULT_HUM_THRESHOLD;
+    _gasPercent = BME680_DEFAULT_GAS_PERCENT;
+
+    _stableSamples = 10;
+    _stableCount = 0;
+    _budget = 0;
+    _lowPower = _applied = _hasReference = false;
+}
+
+/**
+ * Setter for the two fidelity levels
+ * @param low Settings used while readings are stable
+ * @param high Settings used while readings change
+ */
+void BME680PowerManager::setLevels(const BME680PowerLevel &low, const BME680PowerLevel &high) {
+    _low = low;
+    _high = high;
+    _applied = false;
+}
+
+/**
+ * Setter for the change thresholds, a larger change from the reference sample switches to high fidelity
+ * @param temperature Temperature threshold in centi degree celsius
+ * @param pressure Pressure threshold in Pascal
+ * @param humidity Humidity threshold in milli % relative humidity
+ * @param gasPercent Gas resistance threshold in percent of the reference sample
+ */
+void BME680PowerManager::setThresholds(int16_t temperature, uint32_t pressure, uint32_t humidity, uint8_t gasPercent) {
+    _tempThreshold = temperature;
+    _presThreshold = pressure;
+    _humThreshold = humidity;
+    _gasPercent = gasPercent;
+}
+
+/**
+ * Setter for the number of stable readings before switching to low fidelity
+ * @param count Number of consecutive readings within the thresholds
+ */
+void BME680PowerManager::setStableSamples(uint8_t count) {
+    _stableSamples = count;
+}
+
+/**
+ * Setter for the latency budget of a single reading.
+ * A level that exceeds the budget drops its gas phase.
+ * @param duration Maximum measurement duration in milliseconds, 0 for no limit
+ */
+void BME680PowerManager::setLatencyBudget(uint16_t duration) {
+    _budget = duration;
+    _applied = false;
+}
+
+/**
+ * Performs a reading with the current level and adapts the level to the result
+ * @return True on success, False on failure
+ */
+bool BME680PowerManager::performReading() {
+    if (!_applied && !apply(level()))
+        return false;
+
+    if (!_sensor.performReading())
+        return false;
+
+    const struct bme680_field_data &sample = _sensor.getFieldData();
+
+    if (hasChanged(sample)) {
+        /* The stable count restarts from this sample */
+        _stableCount = 0;
+        capture(sample);
+
+        if (_lowPower) {
+            _lowPower = false;
+            _applied = false;
+        }
+    } else if (!_lowPower && ++_stableCount >= _stableSamples) {
+        _lowPower = true;
+        _applied = false;
+        capture(sample);
+    }
+
+    return true;
+}
+
+/**
+ * @return True while the low fidelity level is used
+ */
+bool BME680PowerManager::isLowPower() {
+    return _lowPower;
+}
+
+/**
+ * Get the measurement duration of the current level, a proxy for the energy spent per reading
+ * @return Measurement duration in milliseconds
+ */
+uint16_t BME680PowerManager::getProfileDuration() {
+    const BME680PowerLevel &current = level();
+
+    return tphDuration(current) + (runsGas(current) ? _sensor.getHeaterDuration() : 0);
+}
+
+const BME680PowerLevel &BME680PowerManager::level() {
+    return _lowPower ? _low : _high;
+}
+
+bool BME680PowerManager::apply(const BME680PowerLevel &level) {
+    if (!_sensor.setTemperatureOversampling(level.osTemperature)
+        || !_sensor.setPressureOversampling(level.osPressure)
+        || !_sensor.setHumidityOversampling(level.osHumidity)
+        || !_sensor.setIIRFilterSize(level.filter))
+        return false;
+
+    _sensor.skipGasMeasurement(!runsGas(level));
+
+    _applied = true;
+    return true;
+}
+
+/**
+ * A level runs the gas phase if it asks for it and the heater fits into the latency budget
+ */
+bool BME680PowerManager::runsGas(const BME680PowerLevel &level) {
+    uint16_t heater = _sensor.getHeaterDuration();
+
+    return level.gas && heater > 0 && (_budget == 0 || tphDuration(level) + heater <= _budget);
+}
+
+bool BME680PowerManager::hasChanged(const struct bme680_field_data &sample) {
+    if (!_hasReference)
+        return true;
+
+    int32_t tempDelta = (int32_t) sample.temperature - _reference.temperature;
+
+    if (tempDelta > _tempThreshold || tempDelta < -_tempThreshold)
+        return true;
+
+    if (absDiff(sample.pressure, _reference.pressure) > _presThreshold)
+        return true;
+
+    if (absDiff(sample.humidity, _reference.humidity) > _humThreshold)
+        return true;
+
+    if ((sample.status & BME680_GASM_VALID_MSK) && (_reference.status & BME680_GASM_VALID_MSK)) {
+        uint64_t limit = (uint64_t) _reference.gas_resistance * _gasPercent / 100;
+
+        if (absDiff(sample.gas_resistance, _reference.gas_resistance) > limit)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Keeps the sample as reference. A reading without gas phase keeps the gas reference of the last one that had it.
+ */
+void BME680PowerManager::capture(const struct bme680_field_data &sample) {
+    uint32_t gas = _reference.gas_resistance;
+    bool gasValid = _hasReference && (_reference.status & BME680_GASM_VALID_MSK);
+
+    _reference = sample;
+    _hasReference = true;
+
+    if (!(sample.status & BME680_GASM_VALID_MSK) && gasValid) {
+        _reference.gas_resistance = gas;
+        _reference.status |= BME680_GASM_VALID_MSK;
+    }
+}
+
+/**
+ * Temperature, pressure and humidity conversion time of a level in milliseconds, as in bme680_get_profile_dur()
+ */
+uint16_t BME680PowerManager::tphDuration(const BME680PowerLevel &level) {
+    uint32_t count = measCycles(level.osTemperature) + measCycles(level.osPressure) + measCycles(level.osHumidity);
+
+    return (uint16_t) ((count * 1963 + 477 * 4 + 477 * 5 + 500) / 1000 + 1);
+}
@@ -0,0 +1,66 @@
+#ifndef BME680_POWER_H
+#define BME680_POWER_H
+
+#include "mbed.h"
+#include "mbed_bme680.h"
+
+/**
+ * Sensor settings used by one BME680PowerManager fidelity level.
+ */
+struct BME680PowerLevel {
+    uint8_t osTemperature;  // BME680_OS_NONE to BME680_OS_16X
+    uint8_t osPressure;
+    uint8_t osHumidity;
+    uint8_t filter;         // BME680_FILTER_SIZE_0 to BME680_FILTER_SIZE_127
+    bool gas;               // Run the gas heater phase
+};
+
+/**
+ * Adaptive duty-cycling of the oversampling and the gas heater.
+ * Readings are taken with cheap settings while they are stable and with full fidelity
+ * as soon as a channel moved by more than its threshold from the reference sample. The reference is taken
+ * at each level switch and when a change restarts the stable count, so slow drifts add up.
+ */
+class BME680PowerManager {
+public:
+    BME680PowerManager(BME680 &sensor);
+
+    void setLevels(const BME680PowerLevel &low, const BME680PowerLevel &high);
+
+    void setThresholds(int16_t temperature, uint32_t pressure, uint32_t humidity, uint8_t gasPercent);
+
+    void setStableSamples(uint8_t count);
+
+    void setLatencyBudget(uint16_t duration);
+
+    bool performReading();
+
+    bool isLowPower();
+
+    uint16_t getProfileDuration();
+
+private:
+    BME680 &_sensor;
+    BME680PowerLevel _low, _high;
+    int16_t _tempThreshold;
+    uint32_t _presThreshold, _humThreshold;
+    uint8_t _gasPercent;
+    uint8_t _stableSamples, _stableCount;
+    uint16_t _budget;
+    bool _lowPower, _applied, _hasReference;
+    struct bme680_field_data _reference;  // Sample of the last level switch
+
+    const BME680PowerLevel &level();
+
+    bool apply(const BME680PowerLevel &level);
+
+    bool runsGas(const BME680PowerLevel &level);
+
+    bool hasChanged(const struct bme680_field_data &sample);
+
+    void capture(const struct bme680_field_data &sample);
+
+    static uint16_t tphDuration(const BME680PowerLevel &level);
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "mbed_bme680_record.h"
+
+#include <string.h>
+
+static uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static int64_t zigzagDecode(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static size_t writeVarint(uint8_t *out, uint64_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        out[length++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+
+    out[length++] = (uint8_t) value;
+
+    return length;
+}
+
+/**
+ * @param buffer Output buffer
+ * @param size Size of the output buffer in bytes
+ */
+BME680RecordEncoder::BME680RecordEncoder(uint8_t *buffer, size_t size) {
+    _buffer = buffer;
+    _size = size;
+    reset();
+}
+
+/**
+ * Starts a new stream at the beginning of the buffer
+ */
+void BME680RecordEncoder::reset() {
+    _length = 0;
+    memset(&_previous, 0, sizeof(_previous));
+}
+
+/**
+ * Appends a record to the stream
+ * @param record Record to encode
+ * @return Number of bytes written, 0 if the record does not fit in the remaining buffer
+ */
+size_t BME680RecordEncoder::append(const BME680Record &record) {
+    uint8_t encoded[BME680_RECORD_MAX_SIZE];
+    size_t length = 0;
+
+    encoded[length++] = record.status;
+    length += writeVarint(&encoded[length], (uint32_t) (record.timestamp - _previous.timestamp));
+    length += writeVarint(&encoded[length], zigzagEncode((int64_t) record.temperature - _previous.temperature));
+    length += writeVarint(&encoded[length], zigzagEncode((int64_t) record.pressure - _previous.pressure));
+    length += writeVarint(&encoded[length], zigzagEncode((int64_t) record.humidity - _previous.humidity));
+    length += writeVarint(&encoded[length], zigzagEncode((int64_t) record.gasResistance - _previous.gasResistance));
+
+    if (length > _size - _length)
+        return 0;
+
+    memcpy(&_buffer[_length], encoded, length);
+    _length += length;
+    _previous = record;
+
+    return length;
+}
+
+/**
+ * @return Number of bytes written to the buffer since the last reset
+ */
+size_t BME680RecordEncoder::length() const {
+    return _length;
+}
+
+const uint8_t *BME680RecordEncoder::data() const {
+    return _buffer;
+}
+
+/**
+ * @param buffer Encoded stream
+ * @param length Length of the stream in bytes
+ */
+BME680RecordDecoder::BME680RecordDecoder(const uint8_t *buffer, size_t length) {
+    _buffer = buffer;
+    _length = length;
+    _position = 0;
+    _corrupt = false;
+    memset(&_previous, 0, sizeof(_previous));
+}
+
+/**
+ * Decodes the next record
+ * @param record Receives the record
+ * @return True on success, False at the end of the stream or if it is corrupt
+ */
+bool BME680RecordDecoder::next(BME680Record &record) {
+    uint64_t timestamp, temperature, pressure, humidity, gasResistance;
+
+    if (_corrupt || _position >= _length)
+        return false;
+
+    record.status = _buffer[_position++];
+
+    if (!readVarint(&timestamp) || !readVarint(&temperature) || !readVarint(&pressure)
+        || !readVarint(&humidity) || !readVarint(&gasResistance)) {
+        _corrupt = true;
+        return false;
+    }
+
+    record.timestamp = _previous.timestamp + (uint32_t) timestamp;
+    record.temperature = (int16_t) (_previous.temperature + zigzagDecode(temperature));
+    record.pressure = (uint32_t) (_previous.pressure + zigzagDecode(pressure));
+    record.humidity = (uint32_t) (_previous.humidity + zigzagDecode(humidity));
+    record.gasResistance = (uint32_t) (_previous.gasResistance + zigzagDecode(gasResistance));
+    _previous = record;
+
+    return true;
+}
+
+/**
+ * @return True if decoding stopped on a truncated or malformed record
+ */
+bool BME680RecordDecoder::isCorrupt() const {
+    return _corrupt;
+}
+
+bool BME680RecordDecoder::readVarint(uint64_t *value) {
+    uint64_t result = 0;
+
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+        if (_position >= _length)
+            return false;
+
+        uint8_t byte = _buffer[_position++];
+        result |= (uint64_t) (byte & 0x7F) << shift;
+
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
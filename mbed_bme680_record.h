@@ -0,0 +1,71 @@
+#ifndef BME680_RECORD_H
+#define BME680_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compact binary sample stream.
+ * Each record is the status byte followed by unsigned LEB128 varints: the timestamp delta
+ * and the zigzag encoded deltas of temperature, pressure, humidity and gas resistance to the
+ * previous record of the stream. The first record of a stream is relative to zero.
+ * A steady 1 Hz stream typically needs 8 to 10 bytes per record.
+ * This file has no Mbed dependency so the decoder also builds on the host.
+ */
+
+#define BME680_RECORD_MAX_SIZE 24  // Worst case size of one encoded record
+
+/**
+ * One sample in raw getter units: centi degree Celsius, Pascal, milli % relative humidity and Ohm.
+ */
+struct BME680Record {
+    uint32_t timestamp;  // Milliseconds, wraps around
+    uint8_t status;      // bme680_field_data status bits and gas index
+    int16_t temperature;
+    uint32_t pressure;
+    uint32_t humidity;
+    uint32_t gasResistance;
+};
+
+/**
+ * Streaming encoder writing records into a caller provided buffer.
+ */
+class BME680RecordEncoder {
+public:
+    BME680RecordEncoder(uint8_t *buffer, size_t size);
+
+    void reset();
+
+    size_t append(const BME680Record &record);
+
+    size_t length() const;
+
+    const uint8_t *data() const;
+
+private:
+    uint8_t *_buffer;
+    size_t _size, _length;
+    BME680Record _previous;
+};
+
+/**
+ * Decoder for a stream written by BME680RecordEncoder.
+ */
+class BME680RecordDecoder {
+public:
+    BME680RecordDecoder(const uint8_t *buffer, size_t length);
+
+    bool next(BME680Record &record);
+
+    bool isCorrupt() const;
+
+private:
+    const uint8_t *_buffer;
+    size_t _length, _position;
+    bool _corrupt;
+    BME680Record _previous;
+
+    bool readVarint(uint64_t *value);
+};
+
+#endif
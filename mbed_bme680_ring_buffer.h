@@ -0,0 +1,74 @@
+#ifndef BME680_RING_BUFFER_H
+#define BME680_RING_BUFFER_H
+
+#include "mbed.h"
+
+/**
+ * Fixed-size single-producer/single-consumer ring buffer.
+ * One thread (or event queue) may push while another one pops, without any lock.
+ * @tparam T Item type, copied in and out of the buffer
+ * @tparam N Capacity, must be a power of two
+ */
+template<typename T, uint32_t N>
+class BME680RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "BME680RingBuffer capacity must be a power of two");
+
+public:
+    BME680RingBuffer() : _head(0), _tail(0) {}
+
+    /**
+     * Appends an item, producer side only.
+     * @param item Item to copy into the buffer
+     * @return True on success, False if the buffer is full
+     */
+    bool push(const T &item) {
+        uint32_t head = _head;
+
+        if (head - core_util_atomic_load_u32(&_tail) >= N)
+            return false;
+
+        _buffer[head & (N - 1)] = item;
+        core_util_atomic_store_u32(&_head, head + 1);
+
+        return true;
+    }
+
+    /**
+     * Removes the oldest item, consumer side only.
+     * @param item Receives the oldest item
+     * @return True on success, False if the buffer is empty
+     */
+    bool pop(T &item) {
+        uint32_t tail = _tail;
+
+        if (core_util_atomic_load_u32(&_head) == tail)
+            return false;
+
+        item = _buffer[tail & (N - 1)];
+        core_util_atomic_store_u32(&_tail, tail + 1);
+
+        return true;
+    }
+
+    /**
+     * @return Number of items currently stored
+     */
+    uint32_t size() const {
+        return core_util_atomic_load_u32(&_head) - core_util_atomic_load_u32(&_tail);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static uint32_t capacity() {
+        return N;
+    }
+
+private:
+    T _buffer[N];
+    volatile uint32_t _head;  // written by the producer only
+    volatile uint32_t _tail;  // written by the consumer only
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "mbed_bme680_running_stats.h"
+
+/**
+ * @param fracBits Fractional bits of the mean, values times 2^fracBits must fit in 32 bits
+ */
+BME680RunningStats::BME680RunningStats(uint8_t fracBits) {
+    _fracBits = fracBits;
+    reset();
+}
+
+void BME680RunningStats::reset() {
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+    _min = INT64_MAX;
+    _max = INT64_MIN;
+}
+
+/**
+ * Adds a value to the statistics
+ * @param value New value
+ */
+void BME680RunningStats::add(int64_t value) {
+    int64_t scaled = value * ((int64_t) 1 << _fracBits);
+    int64_t delta1, delta2;
+    uint64_t product, magnitude1, magnitude2;
+
+    _count++;
+
+    delta1 = scaled - _mean;
+    _mean += delta1 / (int64_t) _count;
+    delta2 = scaled - _mean;
+
+    /* Both deltas have the same sign, multiply the magnitudes to use the full unsigned range */
+    magnitude1 = (uint64_t) (delta1 < 0 ? -delta1 : delta1);
+    magnitude2 = (uint64_t) (delta2 < 0 ? -delta2 : delta2);
+    product = magnitude1 * magnitude2;
+
+    if (_m2 > UINT64_MAX - product)
+        _m2 = UINT64_MAX;
+    else
+        _m2 += product;
+
+    if (value < _min)
+        _min = value;
+    if (value > _max)
+        _max = value;
+}
+
+uint32_t BME680RunningStats::count() const {
+    return _count;
+}
+
+/**
+ * @return Mean of the values, rounded to the nearest integer, 0 without values
+ */
+int64_t BME680RunningStats::mean() const {
+    int64_t half = _fracBits > 0 ? ((int64_t) 1 << (_fracBits - 1)) : 0;
+
+    if (_mean < 0)
+        return -((-_mean + half) >> _fracBits);
+
+    return (_mean + half) >> _fracBits;
+}
+
+/**
+ * @return Sample variance of the values in squared value units, 0 with less than two values
+ */
+uint64_t BME680RunningStats::variance() const {
+    if (_count < 2)
+        return 0;
+
+    return (_m2 / (_count - 1)) >> (2 * _fracBits);
+}
+
+/**
+ * @return Smallest value, INT64_MAX without values
+ */
+int64_t BME680RunningStats::min() const {
+    return _min;
+}
+
+/**
+ * @return Largest value, INT64_MIN without values
+ */
+int64_t BME680RunningStats::max() const {
+    return _max;
+}
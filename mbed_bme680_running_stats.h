@@ -0,0 +1,57 @@
+#ifndef BME680_RUNNING_STATS_H
+#define BME680_RUNNING_STATS_H
+
+#include <stdint.h>
+
+/**
+ * Running mean, variance, minimum and maximum of an integer channel (Welford's algorithm).
+ * Uses constant memory and integer arithmetic only, the mean is kept with fracBits fractional bits.
+ */
+class BME680RunningStats {
+public:
+    BME680RunningStats(uint8_t fracBits = 4);
+
+    void reset();
+
+    void add(int64_t value);
+
+    uint32_t count() const;
+
+    int64_t mean() const;
+
+    uint64_t variance() const;
+
+    int64_t min() const;
+
+    int64_t max() const;
+
+private:
+    uint8_t _fracBits;
+    uint32_t _count;
+    int64_t _mean;  // Scaled by 2^fracBits
+    uint64_t _m2;   // Sum of squared deviations, scaled by 2^(2 * fracBits), saturates
+    int64_t _min, _max;
+};
+
+/**
+ * Statistics of a burst of readings, see BME680#performBurst.
+ * Values use the raw getter units: centi degree Celsius, Pascal, milli % relative humidity and Ohm.
+ * Gas resistance only includes readings with a valid and stable gas measurement.
+ */
+struct BME680BurstStats {
+    BME680RunningStats temperature;
+    BME680RunningStats pressure;
+    BME680RunningStats humidity;
+    BME680RunningStats gasResistance;
+
+    BME680BurstStats() : gasResistance(0) {}  // Gas values span 32 bits, no room for fractional bits
+
+    void reset() {
+        temperature.reset();
+        pressure.reset();
+        humidity.reset();
+        gasResistance.reset();
+    }
+};
+
+#endif
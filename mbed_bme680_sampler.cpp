@@ -0,0 +1,170 @@
+#include "mbed_bme680_sampler.h"
+
+BME680Sampler::BME680Sampler(BME680 &sensor, EventQueue &queue) : _sensor(sensor), _queue(queue) {
+    _eventId = 0;
+    _busy = false;
+    _triggeredAt = 0;
+    _overruns = _errors = 0;
+#if DEVICE_LPTICKER
+    _lowPower = false;
+#endif
+}
+
+/**
+ * Starts periodic sampling. The sensor must have been initialized with BME680#begin.
+ * @param period Time between two measurement triggers, should be longer than the measurement duration
+ * @return True on success, False on failure
+ */
+bool BME680Sampler::start(std::chrono::milliseconds period) {
+    if (isRunning())
+        return false;
+
+    _eventId = _queue.call_every(period, callback(this, &BME680Sampler::onTick));
+
+    return _eventId != 0;
+}
+
+#if DEVICE_LPTICKER
+/**
+ * Starts periodic sampling timed by the low power ticker. The sensor must have been initialized with BME680#begin.
+ * Instead of EventQueue timers, which may hold the deep sleep lock, the ticker interrupt posts the trigger to the
+ * queue and a low power timeout posts the read once the measurement duration has elapsed.
+ * @param period Time between two measurement triggers, should be longer than the measurement duration
+ * @return True on success, False on failure
+ */
+bool BME680Sampler::startLowPower(std::chrono::milliseconds period) {
+    if (isRunning())
+        return false;
+
+    _lowPower = true;
+    _ticker.attach(callback(this, &BME680Sampler::onTickIrq), period);
+
+    return true;
+}
+#endif
+
+/**
+ * Stops periodic sampling. A measurement in progress still completes into the buffer.
+ */
+void BME680Sampler::stop() {
+    if (_eventId != 0) {
+        _queue.cancel(_eventId);
+        _eventId = 0;
+    }
+
+#if DEVICE_LPTICKER
+    if (_lowPower) {
+        _ticker.detach();
+        _lowPower = false;
+    }
+#endif
+}
+
+bool BME680Sampler::isRunning() {
+#if DEVICE_LPTICKER
+    if (_lowPower)
+        return true;
+#endif
+
+    return _eventId != 0;
+}
+
+/**
+ * Takes the oldest sample out of the buffer, consumer side.
+ * @param sample Receives the oldest sample
+ * @return True on success, False if no sample is available
+ */
+bool BME680Sampler::pop(BME680Sample &sample) {
+    return _samples.pop(sample);
+}
+
+/**
+ * @return Number of samples lost because the buffer was full or the previous measurement was still running
+ */
+uint32_t BME680Sampler::getOverruns() {
+    return core_util_atomic_load_u32(&_overruns);
+}
+
+/**
+ * @return Number of failed measurements
+ */
+uint32_t BME680Sampler::getErrors() {
+    return core_util_atomic_load_u32(&_errors);
+}
+
+void BME680Sampler::onTick() {
+    if (_busy) {
+        core_util_atomic_incr_u32(&_overruns, 1);
+        return;
+    }
+
+    _triggeredAt = now();
+
+#if DEVICE_LPTICKER
+    if (_lowPower) {
+        uint16_t duration = _sensor.startMeasurement();
+
+        if (duration == 0) {
+            core_util_atomic_incr_u32(&_errors, 1);
+            _sensor.recover();
+            return;
+        }
+
+        _busy = true;
+        _conversion.attach(callback(this, &BME680Sampler::onConversionIrq), std::chrono::milliseconds(duration));
+        return;
+    }
+#endif
+
+    if (_sensor.startMeasurement(_queue, callback(this, &BME680Sampler::onMeasurementDone))) {
+        _busy = true;
+    } else {
+        core_util_atomic_incr_u32(&_errors, 1);
+        _sensor.recover();
+    }
+}
+
+void BME680Sampler::onMeasurementDone(bool success) {
+    _busy = false;
+
+    if (!success) {
+        core_util_atomic_incr_u32(&_errors, 1);
+        _sensor.recover();
+        return;
+    }
+
+    BME680Sample sample;
+    sample.timestamp = _triggeredAt;
+    sample.data = _sensor.getFieldData();
+
+    if (!_samples.push(sample))
+        core_util_atomic_incr_u32(&_overruns, 1);
+}
+
+#if DEVICE_LPTICKER
+/**
+ * Low power ticker interrupt, defers the trigger to the queue
+ */
+void BME680Sampler::onTickIrq() {
+    if (_queue.call(callback(this, &BME680Sampler::onTick)) == 0)
+        core_util_atomic_incr_u32(&_overruns, 1);
+}
+
+/**
+ * Low power timeout interrupt at the end of the measurement duration, defers the read to the queue
+ */
+void BME680Sampler::onConversionIrq() {
+    if (_queue.call(callback(this, &BME680Sampler::onConversionDone)) == 0) {
+        core_util_atomic_incr_u32(&_errors, 1);
+        _busy = false;
+    }
+}
+
+void BME680Sampler::onConversionDone() {
+    onMeasurementDone(_sensor.fetchResult());
+}
+#endif
+
+uint32_t BME680Sampler::now() {
+    return (uint32_t) Kernel::Clock::now().time_since_epoch().count();
+}
@@ -0,0 +1,75 @@
+#ifndef BME680_SAMPLER_H
+#define BME680_SAMPLER_H
+
+#include "mbed.h"
+#include "mbed_bme680.h"
+#include "mbed_bme680_ring_buffer.h"
+
+#ifndef BME680_SAMPLER_BUFFER_SIZE
+#define BME680_SAMPLER_BUFFER_SIZE 16  // Number of buffered samples, must be a power of two
+#endif
+
+/**
+ * Compensated sensor data with the time the measurement was triggered.
+ */
+struct BME680Sample {
+    uint32_t timestamp;  // Kernel::Clock time in milliseconds
+    struct bme680_field_data data;
+};
+
+/**
+ * Continuous forced mode sampling driven by an EventQueue.
+ * Samples are pushed into a lock-free ring buffer which consumer threads drain with BME680Sampler#pop.
+ * The sampler never waits for the consumer, samples that don't fit are dropped and counted as overruns.
+ * A failed measurement is counted as error and followed by BME680#recover.
+ * In low power mode (BME680Sampler#startLowPower) the trigger period and the conversion wait are timed by the
+ * low power ticker, so the MCU may enter deep sleep between samples and while the sensor converts.
+ */
+class BME680Sampler {
+public:
+    BME680Sampler(BME680 &sensor, EventQueue &queue);
+
+    bool start(std::chrono::milliseconds period);
+
+#if DEVICE_LPTICKER
+    bool startLowPower(std::chrono::milliseconds period);
+#endif
+
+    void stop();
+
+    bool isRunning();
+
+    bool pop(BME680Sample &sample);
+
+    uint32_t getOverruns();
+
+    uint32_t getErrors();
+
+private:
+    BME680 &_sensor;
+    EventQueue &_queue;
+    int _eventId;
+    volatile bool _busy;
+    uint32_t _triggeredAt;
+    volatile uint32_t _overruns, _errors;
+    BME680RingBuffer<BME680Sample, BME680_SAMPLER_BUFFER_SIZE> _samples;
+#if DEVICE_LPTICKER
+    bool _lowPower;
+    LowPowerTicker _ticker;
+    LowPowerTimeout _conversion;
+
+    void onTickIrq();
+
+    void onConversionIrq();
+
+    void onConversionDone();
+#endif
+
+    void onTick();
+
+    void onMeasurementDone(bool success);
+
+    static uint32_t now();
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef BME680_STATS_H
+#define BME680_STATS_H
+
+#include <stdint.h>
+
+#define BME680_STATS_BUCKETS 12  // Bucket 0 is below 128 us, bucket n starts at 2^(n + 6) us, the last one is open ended
+
+/**
+ * Latency distribution of one phase of a reading, in microseconds.
+ */
+struct BME680PhaseStats {
+    uint32_t count;
+    uint32_t last;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[BME680_STATS_BUCKETS];
+
+    void add(uint32_t duration) {
+        uint8_t bucket = 0;
+
+        for (uint32_t limit = 128; bucket < BME680_STATS_BUCKETS - 1 && duration >= limit; limit <<= 1)
+            bucket++;
+
+        count++;
+        last = duration;
+        total += duration;
+        histogram[bucket]++;
+
+        if (duration > max)
+            max = duration;
+    }
+};
+
+/**
+ * Hot path instrumentation of a BME680, only available with BME680_STATS defined.
+ */
+struct BME680Stats {
+    BME680PhaseStats settings;  // Dirty settings, heater profile and gas control writes
+    BME680PhaseStats trigger;   // Forced mode write
+    BME680PhaseStats wait;      // From the trigger to the start of the data read
+    BME680PhaseStats read;      // Data read and compensation
+    uint32_t transactions;      // I2C transactions
+    uint32_t bytesWritten;      // Bytes written, register addresses included
+    uint32_t bytesRead;
+    uint32_t nacks;             // Failed I2C transactions (NACK or timeout)
+    uint32_t errors;            // Failed measurement starts or data reads
+    uint32_t retries;           // Repeated I2C transactions
+    uint32_t recoveries;        // BME680#recover calls
+    uint32_t busClears;         // Bus clears by SCL toggling
+    uint32_t reinits;           // Reinitializations after the chip ID was lost
+    uint16_t lastProfileDuration;  // Milliseconds
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BME680_THRESHOLDS_H
+#define BME680_THRESHOLDS_H
+
+#include <stdint.h>
+
+/**
+ * Change thresholds shared by BME680PowerManager and BME680ChangeDetector, internal to the library.
+ */
+
+#define BME680_DEFAULT_TEMP_THRESHOLD 10     // 0.1 degC
+#define BME680_DEFAULT_PRES_THRESHOLD 50     // 0.5 hPa
+#define BME680_DEFAULT_HUM_THRESHOLD 1000    // 1 %RH
+#define BME680_DEFAULT_GAS_PERCENT 5         // Percent of the reference gas resistance
+
+static inline uint32_t absDiff(uint32_t a, uint32_t b) {
+    return a > b ? a - b : b - a;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "mbed_bme680_warmup.h"
+
+/**
+ * @param sensor Sensor to control, initialized with BME680#begin
+ * @param heaterTemp Heater temperature in degrees Centigrade
+ * @param heaterTime Heating time in milliseconds once the heater is settled
+ */
+BME680GasWarmup::BME680GasWarmup(BME680 &sensor, uint16_t heaterTemp, uint16_t heaterTime) : _sensor(sensor) {
+    _heaterTemp = heaterTemp;
+    _heaterTime = heaterTime;
+    _warmupTime = heaterTime / 5 > 0 ? heaterTime / 5 : 1;
+    _settleCount = 3;
+    _maxRetries = 2;
+    _interval = 0;
+    reset();
+}
+
+/**
+ * Setter for the warm-up behaviour
+ * @param warmupTime Heating time in milliseconds used until the heater is settled
+ * @param settleCount Consecutive stable readings needed to consider the heater settled
+ * @param maxRetries Immediate retries of an unstable reading while warming up
+ */
+void BME680GasWarmup::setWarmup(uint16_t warmupTime, uint8_t settleCount, uint8_t maxRetries) {
+    _warmupTime = warmupTime > 0 ? warmupTime : 1;
+    _settleCount = settleCount > 0 ? settleCount : 1;
+    _maxRetries = maxRetries;
+    _heaterApplied = false;
+}
+
+/**
+ * Restarts the warm-up, e.g. after the sensor was powered down
+ */
+void BME680GasWarmup::reset() {
+    _stableCount = 0;
+    _settled = false;
+    _heaterApplied = false;
+    _hasLastReading = false;
+}
+
+/**
+ * Performs a reading, retried while the heater warms up
+ * @return True on success, False on failure. The gas reading may still be unstable, see BME680#isGasHeatingSetupStable
+ */
+bool BME680GasWarmup::performReading() {
+    /* Retries don't count, the interval reflects the caller's sampling rate */
+    Kernel::Clock::time_point now = Kernel::Clock::now();
+
+    if (_hasLastReading) {
+        uint32_t elapsed = (uint32_t) (now - _lastReading).count();
+
+        /* Exponential average with a weight of 1/4 for the newest interval */
+        _interval = _interval == 0 ? elapsed : (3 * _interval + elapsed) / 4;
+    }
+
+    _lastReading = now;
+    _hasLastReading = true;
+
+    for (uint8_t attempt = 0; attempt <= _maxRetries; attempt++) {
+        if (!_heaterApplied && !applyHeater())
+            return false;
+
+        if (!_sensor.performReading())
+            return false;
+
+        /* Readings without gas phase tell nothing about the heater */
+        if (!_sensor.isGasMeasured())
+            break;
+
+        bool stable = _sensor.isGasHeatingSetupStable();
+        bool wasSettled = _settled;
+
+        track(stable);
+
+        if (stable || wasSettled)
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @return True once enough consecutive readings had a stable heater
+ */
+bool BME680GasWarmup::isSettled() {
+    return _settled;
+}
+
+/**
+ * Estimates the time until the heater is settled, based on the missing stable readings
+ * and the average time between readings
+ * @return Estimated time in milliseconds, 0 if already settled
+ */
+uint32_t BME680GasWarmup::getTimeToStable() {
+    if (_settled)
+        return 0;
+
+    uint32_t interval = _interval;
+
+    if (interval == 0)
+        interval = _sensor.getProfileDuration();
+
+    return (uint32_t) (_settleCount - _stableCount) * interval;
+}
+
+bool BME680GasWarmup::applyHeater() {
+    if (!_sensor.setGasHeater(_heaterTemp, _settled ? _heaterTime : _warmupTime))
+        return false;
+
+    _heaterApplied = true;
+    return true;
+}
+
+void BME680GasWarmup::track(bool stable) {
+    if (stable) {
+        if (!_settled && ++_stableCount >= _settleCount) {
+            _settled = true;
+            _heaterApplied = false;
+        }
+    } else {
+        _stableCount = 0;
+
+        if (_settled) {
+            _settled = false;
+            _heaterApplied = false;
+        }
+    }
+}
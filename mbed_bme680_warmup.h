@@ -0,0 +1,41 @@
+#ifndef BME680_WARMUP_H
+#define BME680_WARMUP_H
+
+#include "mbed.h"
+#include "mbed_bme680.h"
+
+/**
+ * Tracks the gas heater stabilization over consecutive readings.
+ * While the heater warms up, readings use a shortened heating time and are retried right away
+ * when the heater did not reach a stable temperature. Once enough consecutive readings were stable
+ * the heater is considered settled and the full heating time is used.
+ */
+class BME680GasWarmup {
+public:
+    BME680GasWarmup(BME680 &sensor, uint16_t heaterTemp, uint16_t heaterTime);
+
+    void setWarmup(uint16_t warmupTime, uint8_t settleCount, uint8_t maxRetries);
+
+    bool performReading();
+
+    bool isSettled();
+
+    uint32_t getTimeToStable();
+
+    void reset();
+
+private:
+    BME680 &_sensor;
+    uint16_t _heaterTemp, _heaterTime, _warmupTime;
+    uint8_t _settleCount, _maxRetries, _stableCount;
+    bool _settled, _heaterApplied;
+    Kernel::Clock::time_point _lastReading;
+    bool _hasLastReading;
+    uint32_t _interval;  // Average time between readings in milliseconds
+
+    bool applyHeater();
+
+    void track(bool stable);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <chrono>
+
+#include "bme680_simulator.h"
+#include "mbed_bme680.h"
+#include "mbed_bme680_batch.h"
+
+/*
+ * Host benchmark: bus traffic and blocked time per reading for settings combinations, measured in the
+ * virtual time of the simulated bus at 400 kHz, and the host cost of the compensation paths.
+ * The numbers are meant for comparing changes, not for absolute timing on a board.
+ */
+
+#define READINGS 100
+#define SAMPLES 100000
+
+struct Settings {
+    const char *name;
+    uint8_t osTemp, osPres, osHum, filter;
+    uint16_t heaterTemp, heaterTime;
+    bool direct;
+};
+
+static const Settings settings[] = {
+        {"default 8x/4x/2x gas", BME680_OS_8X, BME680_OS_4X, BME680_OS_2X, BME680_FILTER_SIZE_3, 320, 150, false},
+        {"default direct", BME680_OS_8X, BME680_OS_4X, BME680_OS_2X, BME680_FILTER_SIZE_3, 320, 150, true},
+        {"1x/1x/1x no gas", BME680_OS_1X, BME680_OS_1X, BME680_OS_1X, BME680_FILTER_SIZE_0, 0, 0, false},
+        {"1x/1x/1x no gas direct", BME680_OS_1X, BME680_OS_1X, BME680_OS_1X, BME680_FILTER_SIZE_0, 0, 0, true},
+        {"16x/16x/16x no gas", BME680_OS_16X, BME680_OS_16X, BME680_OS_16X, BME680_FILTER_SIZE_127, 0, 0, false},
+        {"2x/16x/1x gas 20 ms", BME680_OS_2X, BME680_OS_16X, BME680_OS_1X, BME680_FILTER_SIZE_3, 300, 20, false},
+};
+
+static void benchReadings(const Settings &setting) {
+    BME680Simulator simulator;
+    I2C i2c(I2C_SDA, I2C_SCL);
+    BME680 sensor(0x77 << 1, i2c);
+
+    i2c.frequency(400000);
+
+    if (!sensor.begin()) {
+        printf("%-26s begin failed\n", setting.name);
+        return;
+    }
+
+    sensor.setTemperatureOversampling(setting.osTemp);
+    sensor.setPressureOversampling(setting.osPres);
+    sensor.setHumidityOversampling(setting.osHum);
+    sensor.setIIRFilterSize(setting.filter);
+    sensor.setGasHeater(setting.heaterTemp, setting.heaterTime);
+    sensor.setDirectMode(setting.direct);
+
+    /* The first reading writes the settings, the steady state is measured */
+    sensor.performReading();
+    sensor.resetStats();
+
+    uint64_t start = mbed_mock::nowUs();
+
+    for (int i = 0; i < READINGS; i++)
+        sensor.performReading();
+
+    const BME680Stats &stats = sensor.getStats();
+
+    printf("%-26s %6.1f %8.1f %10.2f %10.2f %10.1f\n", setting.name,
+           stats.transactions / (double) READINGS,
+           (stats.bytesRead + stats.bytesWritten) / (double) READINGS,
+           (mbed_mock::nowUs() - start) / 1000.0 / READINGS,
+           stats.wait.count ? stats.wait.total / 1000.0 / stats.wait.count : 0.0,
+           stats.read.count ? stats.read.total / (double) stats.read.count : 0.0);
+}
+
+template<typename F>
+static double nsPerSample(F run) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    run();
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SAMPLES;
+}
+
+static void benchCompensation() {
+    static uint8_t raw[SAMPLES][BME680_FIELD_LENGTH];
+    static BME680Batch<SAMPLES> batch;
+    BME680Compensation compensation;
+    volatile uint32_t sink = 0;
+
+    compensation.load(BME680Simulator::calibration());
+
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        uint32_t temp = 450000 + i % 100000, pres = 300000 + i % 150000;
+        uint16_t hum = (uint16_t) (15000 + i % 20000), gas = (uint16_t) (i % 1024);
+
+        memset(raw[i], 0, BME680_FIELD_LENGTH);
+        raw[i][0] = BME680_NEW_DATA_MSK;
+        raw[i][2] = (uint8_t) (pres >> 12);
+        raw[i][3] = (uint8_t) (pres >> 4);
+        raw[i][4] = (uint8_t) (pres << 4);
+        raw[i][5] = (uint8_t) (temp >> 12);
+        raw[i][6] = (uint8_t) (temp >> 4);
+        raw[i][7] = (uint8_t) (temp << 4);
+        raw[i][8] = (uint8_t) (hum >> 8);
+        raw[i][9] = (uint8_t) hum;
+        raw[i][13] = (uint8_t) (gas >> 2);
+        raw[i][14] = (uint8_t) ((gas << 6) | (i % 16));
+    }
+
+    double scalar = nsPerSample([&]() {
+        struct bme680_field_data data;
+
+        for (uint32_t i = 0; i < SAMPLES; i++) {
+            compensation.compensate(raw[i], &data);
+            sink = sink + data.pressure;
+        }
+    });
+
+    batch.clear();
+    for (uint32_t i = 0; i < SAMPLES; i++)
+        batch.addRaw(raw[i]);
+
+    double columns = nsPerSample([&]() {
+        batch.compensate(compensation);
+        sink = sink + batch.getPressures()[SAMPLES - 1];
+    });
+
+    printf("\ncompensation per sample: %.1f ns scalar, %.1f ns batch columns\n", scalar, columns);
+}
+
+int main() {
+    printf("%-26s %6s %8s %10s %10s %10s\n", "settings", "trans", "bytes", "blocked ms", "wait ms", "read us");
+
+    for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); i++)
+        benchReadings(settings[i]);
+
+    benchCompensation();
+
+    return 0;
+}
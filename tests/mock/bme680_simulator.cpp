@@ -0,0 +1,247 @@
+#include "bme680_simulator.h"
+
+/* meas_status_0 bits */
+#define MEASURING_MSK 0x20
+#define GAS_MEASURING_MSK 0x40
+
+BME680Simulator::BME680Simulator(int address) : _address(address) {
+    _present = true;
+    _stable = true;
+    _writes = _measurements = 0;
+    memset(_regWrites, 0, sizeof(_regWrites));
+
+    /* About 25 degC, 1000 hPa, 40 %RH and 55 kOhm with the calibration below */
+    setAdc(494000, 355000, 20300, 680, 7);
+    powerCycle();
+
+    mbed_mock::attach(_address, this);
+}
+
+BME680Simulator::~BME680Simulator() {
+    mbed_mock::detach(_address);
+}
+
+struct bme680_calib_data BME680Simulator::calibration() {
+    struct bme680_calib_data calib;
+
+    memset(&calib, 0, sizeof(calib));
+    calib.par_t1 = 25948;
+    calib.par_t2 = 26453;
+    calib.par_t3 = 3;
+    calib.par_p1 = 36157;
+    calib.par_p2 = -10384;
+    calib.par_p3 = 88;
+    calib.par_p4 = 7257;
+    calib.par_p5 = -150;
+    calib.par_p6 = 30;
+    calib.par_p7 = 44;
+    calib.par_p8 = -1473;
+    calib.par_p9 = -2256;
+    calib.par_p10 = 30;
+    calib.par_h1 = 774;
+    calib.par_h2 = 1021;
+    calib.par_h3 = 0;
+    calib.par_h4 = 45;
+    calib.par_h5 = 20;
+    calib.par_h6 = 120;
+    calib.par_h7 = -100;
+    calib.par_gh1 = -30;
+    calib.par_gh2 = -12154;
+    calib.par_gh3 = 18;
+    calib.res_heat_range = 1;
+    calib.res_heat_val = 41;
+    calib.range_sw_err = -1;
+
+    return calib;
+}
+
+void BME680Simulator::setAdc(uint32_t temperature, uint32_t pressure, uint16_t humidity, uint16_t gas,
+                             uint8_t gasRange) {
+    _tempAdc = temperature;
+    _presAdc = pressure;
+    _humAdc = humidity;
+    _gasAdc = gas;
+    _gasRange = gasRange;
+}
+
+void BME680Simulator::setHeaterStable(bool stable) {
+    _stable = stable;
+}
+
+void BME680Simulator::powerCycle() {
+    struct bme680_calib_data calib = calibration();
+    uint8_t *coeff1 = &_regs[BME680_COEFF_ADDR1];
+    uint8_t *coeff2 = &_regs[BME680_COEFF_ADDR2];
+
+    memset(_regs, 0, sizeof(_regs));
+    _pointer = 0;
+    _measuring = false;
+
+    _regs[BME680_CHIP_ID_ADDR] = BME680_CHIP_ID;
+
+    /* Calibration block, in the layout the Bosch API parses */
+    coeff1[0] = (uint8_t) calib.par_t2;
+    coeff1[1] = (uint8_t) (calib.par_t2 >> 8);
+    coeff1[2] = (uint8_t) calib.par_t3;
+    coeff1[4] = (uint8_t) calib.par_p1;
+    coeff1[5] = (uint8_t) (calib.par_p1 >> 8);
+    coeff1[6] = (uint8_t) calib.par_p2;
+    coeff1[7] = (uint8_t) (calib.par_p2 >> 8);
+    coeff1[8] = (uint8_t) calib.par_p3;
+    coeff1[10] = (uint8_t) calib.par_p4;
+    coeff1[11] = (uint8_t) (calib.par_p4 >> 8);
+    coeff1[12] = (uint8_t) calib.par_p5;
+    coeff1[13] = (uint8_t) (calib.par_p5 >> 8);
+    coeff1[14] = (uint8_t) calib.par_p7;
+    coeff1[15] = (uint8_t) calib.par_p6;
+    coeff1[18] = (uint8_t) calib.par_p8;
+    coeff1[19] = (uint8_t) (calib.par_p8 >> 8);
+    coeff1[20] = (uint8_t) calib.par_p9;
+    coeff1[21] = (uint8_t) (calib.par_p9 >> 8);
+    coeff1[22] = calib.par_p10;
+    coeff2[0] = (uint8_t) (calib.par_h2 >> 4);
+    coeff2[1] = (uint8_t) (((calib.par_h2 & 0x0f) << 4) | (calib.par_h1 & 0x0f));
+    coeff2[2] = (uint8_t) (calib.par_h1 >> 4);
+    coeff2[3] = (uint8_t) calib.par_h3;
+    coeff2[4] = (uint8_t) calib.par_h4;
+    coeff2[5] = (uint8_t) calib.par_h5;
+    coeff2[6] = calib.par_h6;
+    coeff2[7] = (uint8_t) calib.par_h7;
+    coeff2[8] = (uint8_t) calib.par_t1;
+    coeff2[9] = (uint8_t) (calib.par_t1 >> 8);
+    coeff2[10] = (uint8_t) calib.par_gh2;
+    coeff2[11] = (uint8_t) (calib.par_gh2 >> 8);
+    coeff2[12] = (uint8_t) calib.par_gh1;
+    coeff2[13] = (uint8_t) calib.par_gh3;
+
+    _regs[BME680_ADDR_RES_HEAT_VAL_ADDR] = (uint8_t) calib.res_heat_val;
+    _regs[BME680_ADDR_RES_HEAT_RANGE_ADDR] = (uint8_t) (calib.res_heat_range << 4);
+    _regs[BME680_ADDR_RANGE_SW_ERR_ADDR] = (uint8_t) (calib.range_sw_err << 4);
+}
+
+void BME680Simulator::setPresent(bool present) {
+    _present = present;
+}
+
+uint8_t BME680Simulator::reg(uint8_t address) {
+    update();
+    return _regs[address];
+}
+
+uint32_t BME680Simulator::writes() const {
+    return _writes;
+}
+
+uint32_t BME680Simulator::writes(uint8_t address) const {
+    return _regWrites[address];
+}
+
+uint32_t BME680Simulator::measurements() const {
+    return _measurements;
+}
+
+uint32_t BME680Simulator::measurementTime() {
+    static const uint8_t cycles[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+    uint8_t ctrlMeas = _regs[BME680_CONF_T_P_MODE_ADDR];
+    uint32_t measCycles = cycles[ctrlMeas >> 5] + cycles[(ctrlMeas >> 2) & 7]
+                          + cycles[_regs[BME680_CONF_OS_H_ADDR] & BME680_OSH_MSK];
+    uint32_t us = measCycles * 1963 + 477 * 4 + 477 * 5 + 500;
+    uint8_t ctrlGas1 = _regs[BME680_CONF_ODR_RUN_GAS_NBC_ADDR];
+
+    if (ctrlGas1 & BME680_RUN_GAS_MSK) {
+        uint8_t wait = _regs[BME680_GAS_WAIT0_ADDR + (ctrlGas1 & BME680_NBCONV_MSK)];
+
+        us += (uint32_t) (wait & 0x3f) * (1U << (2 * (wait >> 6))) * 1000;
+    }
+
+    return us;
+}
+
+bool BME680Simulator::write(const uint8_t *data, int length) {
+    if (!_present)
+        return false;
+
+    update();
+
+    /* A single byte sets the read pointer, longer writes are register/value pairs */
+    _pointer = data[0];
+
+    for (int i = 0; i + 1 < length; i += 2)
+        writeRegister(data[i], data[i + 1]);
+
+    return true;
+}
+
+bool BME680Simulator::read(uint8_t *data, int length) {
+    if (!_present)
+        return false;
+
+    update();
+
+    for (int i = 0; i < length; i++)
+        data[i] = _regs[(uint8_t) (_pointer + i)];
+
+    return true;
+}
+
+void BME680Simulator::writeRegister(uint8_t address, uint8_t value) {
+    _writes++;
+    _regWrites[address]++;
+
+    if (address == BME680_SOFT_RESET_ADDR) {
+        if (value == BME680_SOFT_RESET_CMD)
+            powerCycle();
+        return;
+    }
+
+    _regs[address] = value;
+
+    if (address != BME680_CONF_T_P_MODE_ADDR)
+        return;
+
+    if ((value & BME680_MODE_MSK) == BME680_FORCED_MODE) {
+        _measuring = true;
+        _readyAt = mbed_mock::nowUs() + measurementTime();
+        _measurements++;
+
+        /* New data is cleared when a measurement starts */
+        _regs[BME680_FIELD0_ADDR] = MEASURING_MSK
+                                    | (_regs[BME680_CONF_ODR_RUN_GAS_NBC_ADDR] & BME680_RUN_GAS_MSK ? GAS_MEASURING_MSK : 0);
+    } else {
+        _measuring = false;
+        _regs[BME680_FIELD0_ADDR] &= (uint8_t) ~(MEASURING_MSK | GAS_MEASURING_MSK);
+    }
+}
+
+/**
+ * Completes the running measurement once its time has elapsed
+ */
+void BME680Simulator::update() {
+    if (!_measuring || mbed_mock::nowUs() < _readyAt)
+        return;
+
+    uint8_t ctrlGas1 = _regs[BME680_CONF_ODR_RUN_GAS_NBC_ADDR];
+    bool runGas = ctrlGas1 & BME680_RUN_GAS_MSK;
+    uint8_t *field = &_regs[BME680_FIELD0_ADDR];
+
+    _measuring = false;
+    _regs[BME680_CONF_T_P_MODE_ADDR] &= (uint8_t) ~BME680_MODE_MSK;
+
+    field[0] = BME680_NEW_DATA_MSK | (ctrlGas1 & BME680_NBCONV_MSK);
+    field[1]++;
+    field[2] = (uint8_t) (_presAdc >> 12);
+    field[3] = (uint8_t) (_presAdc >> 4);
+    field[4] = (uint8_t) (_presAdc << 4);
+    field[5] = (uint8_t) (_tempAdc >> 12);
+    field[6] = (uint8_t) (_tempAdc >> 4);
+    field[7] = (uint8_t) (_tempAdc << 4);
+    field[8] = (uint8_t) (_humAdc >> 8);
+    field[9] = (uint8_t) _humAdc;
+
+    /* Without the gas phase the gas registers keep the result of the last one */
+    if (runGas) {
+        field[13] = (uint8_t) (_gasAdc >> 2);
+        field[14] = (uint8_t) ((_gasAdc << 6) | BME680_GASM_VALID_MSK | (_stable ? BME680_HEAT_STAB_MSK : 0)
+                               | (_gasRange & BME680_GAS_RANGE_MSK));
+    }
+}
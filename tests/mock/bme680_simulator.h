@@ -0,0 +1,76 @@
+#ifndef BME680_SIMULATOR_H
+#define BME680_SIMULATOR_H
+
+#include "mbed.h"
+#include "bme680.h"
+
+/**
+ * Register map of a BME680 on the simulated I2C bus.
+ * Holds a calibration block, and runs forced mode measurements in virtual time: the field data becomes
+ * available once the conversion time of the oversampling settings and the heater duration has elapsed.
+ * The ADC values of the following measurements are set with BME680Simulator#setAdc.
+ */
+class BME680Simulator : public mbed_mock::I2CDevice {
+public:
+    explicit BME680Simulator(int address = 0x77 << 1);
+
+    ~BME680Simulator();
+
+    /**
+     * Calibration the simulated sensor reports, a typical factory calibration
+     */
+    static struct bme680_calib_data calibration();
+
+    void setAdc(uint32_t temperature, uint32_t pressure, uint16_t humidity, uint16_t gas, uint8_t gasRange);
+
+    /**
+     * Lets the heater report an unstable temperature
+     */
+    void setHeaterStable(bool stable);
+
+    /**
+     * Restores the register defaults as after a power loss, the calibration stays
+     */
+    void powerCycle();
+
+    /**
+     * Stops answering on the bus, e.g. a disconnected sensor
+     */
+    void setPresent(bool present);
+
+    uint8_t reg(uint8_t address);
+
+    uint32_t writes() const;  // Register writes
+
+    uint32_t writes(uint8_t address) const;  // Writes of one register
+
+    uint32_t measurements() const;  // Started measurements
+
+    /**
+     * @return Duration of the measurement the current settings start, in microseconds
+     */
+    uint32_t measurementTime();
+
+    bool write(const uint8_t *data, int length) override;
+
+    bool read(uint8_t *data, int length) override;
+
+private:
+    int _address;
+    uint8_t _regs[256];
+    uint8_t _pointer;
+    bool _present, _stable;
+    bool _measuring;
+    uint64_t _readyAt;
+    uint32_t _tempAdc, _presAdc;
+    uint16_t _humAdc, _gasAdc;
+    uint8_t _gasRange;
+    uint32_t _writes, _measurements;
+    uint32_t _regWrites[256];
+
+    void writeRegister(uint8_t address, uint8_t value);
+
+    void update();
+};
+
+#endif
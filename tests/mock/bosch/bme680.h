@@ -0,0 +1,202 @@
+#ifndef BME680_H_
+#define BME680_H_
+
+/*
+ * Host stand-in for the Bosch Sensortec BME680 API v3.5.x, the declarations and constants the library uses.
+ * bme680_mock.cpp implements the functions with the same register traffic as the Bosch API, so the library
+ * talks to the simulated sensor just as it would to the real one. Configure the host build with
+ * -DBME680_BOSCH_DIR=<path to BME680_driver> to use the Bosch sources instead.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BME680_OK INT8_C(0)
+#define BME680_E_NULL_PTR INT8_C(-1)
+#define BME680_E_COM_FAIL INT8_C(-2)
+#define BME680_E_DEV_NOT_FOUND INT8_C(-3)
+#define BME680_E_INVALID_LENGTH INT8_C(-4)
+#define BME680_W_NO_NEW_DATA INT8_C(2)
+
+#define BME680_CHIP_ID UINT8_C(0x61)
+#define BME680_SOFT_RESET_CMD UINT8_C(0xb6)
+
+#define BME680_SPI_INTF 0
+#define BME680_I2C_INTF 1
+
+#define BME680_SLEEP_MODE UINT8_C(0)
+#define BME680_FORCED_MODE UINT8_C(1)
+
+#define BME680_OS_NONE UINT8_C(0)
+#define BME680_OS_1X UINT8_C(1)
+#define BME680_OS_2X UINT8_C(2)
+#define BME680_OS_4X UINT8_C(3)
+#define BME680_OS_8X UINT8_C(4)
+#define BME680_OS_16X UINT8_C(5)
+
+#define BME680_FILTER_SIZE_0 UINT8_C(0)
+#define BME680_FILTER_SIZE_1 UINT8_C(1)
+#define BME680_FILTER_SIZE_3 UINT8_C(2)
+#define BME680_FILTER_SIZE_7 UINT8_C(3)
+#define BME680_FILTER_SIZE_15 UINT8_C(4)
+#define BME680_FILTER_SIZE_31 UINT8_C(5)
+#define BME680_FILTER_SIZE_63 UINT8_C(6)
+#define BME680_FILTER_SIZE_127 UINT8_C(7)
+
+#define BME680_ENABLE_HEATER UINT8_C(0x00)
+#define BME680_DISABLE_HEATER UINT8_C(0x08)
+#define BME680_DISABLE_GAS_MEAS UINT8_C(0x00)
+#define BME680_ENABLE_GAS_MEAS UINT8_C(0x01)
+
+#define BME680_OST_SEL UINT16_C(1)
+#define BME680_OSP_SEL UINT16_C(2)
+#define BME680_OSH_SEL UINT16_C(4)
+#define BME680_GAS_MEAS_SEL UINT16_C(8)
+#define BME680_FILTER_SEL UINT16_C(16)
+#define BME680_HCNTRL_SEL UINT16_C(32)
+#define BME680_RUN_GAS_SEL UINT16_C(64)
+#define BME680_NBCONV_SEL UINT16_C(128)
+#define BME680_GAS_SENSOR_SEL (BME680_GAS_MEAS_SEL | BME680_RUN_GAS_SEL | BME680_NBCONV_SEL)
+
+#define BME680_NEW_DATA_MSK UINT8_C(0x80)
+#define BME680_GAS_INDEX_MSK UINT8_C(0x0f)
+#define BME680_GAS_RANGE_MSK UINT8_C(0x0f)
+#define BME680_GASM_VALID_MSK UINT8_C(0x20)
+#define BME680_HEAT_STAB_MSK UINT8_C(0x10)
+#define BME680_RUN_GAS_MSK UINT8_C(0x10)
+#define BME680_NBCONV_MSK UINT8_C(0X0f)
+#define BME680_FILTER_MSK UINT8_C(0X1c)
+#define BME680_OST_MSK UINT8_C(0XE0)
+#define BME680_OSP_MSK UINT8_C(0X1C)
+#define BME680_OSH_MSK UINT8_C(0X07)
+#define BME680_HCTRL_MSK UINT8_C(0x08)
+#define BME680_MODE_MSK UINT8_C(0x03)
+
+#define BME680_FIELD_LENGTH UINT8_C(15)
+#define BME680_FIELD_ADDR_OFFSET UINT8_C(17)
+
+#define BME680_COEFF_ADDR1 UINT8_C(0x89)
+#define BME680_COEFF_ADDR2 UINT8_C(0xe1)
+#define BME680_ADDR_RES_HEAT_VAL_ADDR UINT8_C(0x00)
+#define BME680_ADDR_RES_HEAT_RANGE_ADDR UINT8_C(0x02)
+#define BME680_ADDR_RANGE_SW_ERR_ADDR UINT8_C(0x04)
+#define BME680_FIELD0_ADDR UINT8_C(0x1d)
+#define BME680_RES_HEAT0_ADDR UINT8_C(0x5a)
+#define BME680_GAS_WAIT0_ADDR UINT8_C(0x64)
+#define BME680_CONF_HEAT_CTRL_ADDR UINT8_C(0x70)
+#define BME680_CONF_ODR_RUN_GAS_NBC_ADDR UINT8_C(0x71)
+#define BME680_CONF_OS_H_ADDR UINT8_C(0x72)
+#define BME680_CONF_T_P_MODE_ADDR UINT8_C(0x74)
+#define BME680_CONF_ODR_FILT_ADDR UINT8_C(0x75)
+#define BME680_CHIP_ID_ADDR UINT8_C(0xd0)
+#define BME680_SOFT_RESET_ADDR UINT8_C(0xe0)
+
+#define BME680_TMP_BUFFER_LENGTH UINT8_C(40)
+#define BME680_REG_BUFFER_LENGTH UINT8_C(6)
+#define BME680_COEFF_ADDR1_LEN UINT8_C(25)
+#define BME680_COEFF_ADDR2_LEN UINT8_C(16)
+
+typedef int8_t (*bme680_com_fptr_t)(uint8_t dev_id, uint8_t reg_addr, uint8_t *data, uint16_t len);
+
+typedef void (*bme680_delay_fptr_t)(uint32_t period);
+
+struct bme680_field_data {
+    uint8_t status;
+    uint8_t gas_index;
+    uint8_t meas_index;
+    int16_t temperature;
+    uint32_t pressure;
+    uint32_t humidity;
+    uint32_t gas_resistance;
+};
+
+struct bme680_calib_data {
+    uint16_t par_h1;
+    uint16_t par_h2;
+    int8_t par_h3;
+    int8_t par_h4;
+    int8_t par_h5;
+    uint8_t par_h6;
+    int8_t par_h7;
+    int8_t par_gh1;
+    int16_t par_gh2;
+    int8_t par_gh3;
+    uint16_t par_t1;
+    int16_t par_t2;
+    int8_t par_t3;
+    uint16_t par_p1;
+    int16_t par_p2;
+    int8_t par_p3;
+    int16_t par_p4;
+    int16_t par_p5;
+    int8_t par_p6;
+    int8_t par_p7;
+    int16_t par_p8;
+    int16_t par_p9;
+    uint8_t par_p10;
+    int32_t t_fine;
+    uint8_t res_heat_range;
+    int8_t res_heat_val;
+    int8_t range_sw_err;
+};
+
+struct bme680_tph_sett {
+    uint8_t os_hum;
+    uint8_t os_temp;
+    uint8_t os_pres;
+    uint8_t filter;
+};
+
+struct bme680_gas_sett {
+    uint8_t nb_conv;
+    uint8_t heatr_ctrl;
+    uint8_t run_gas;
+    uint16_t heatr_temp;
+    uint16_t heatr_dur;
+};
+
+struct bme680_dev {
+    uint8_t chip_id;
+    uint8_t dev_id;
+    int intf;
+    uint8_t mem_page;
+    int8_t amb_temp;
+    struct bme680_calib_data calib;
+    struct bme680_tph_sett tph_sett;
+    struct bme680_gas_sett gas_sett;
+    uint8_t power_mode;
+    uint8_t new_fields;
+    uint8_t info_msk;
+    bme680_com_fptr_t read;
+    bme680_com_fptr_t write;
+    bme680_delay_fptr_t delay_ms;
+    int8_t com_rslt;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int8_t bme680_init(struct bme680_dev *dev);
+
+int8_t bme680_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint8_t len, struct bme680_dev *dev);
+
+int8_t bme680_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint16_t len, struct bme680_dev *dev);
+
+int8_t bme680_soft_reset(struct bme680_dev *dev);
+
+int8_t bme680_set_sensor_mode(struct bme680_dev *dev);
+
+int8_t bme680_get_sensor_mode(struct bme680_dev *dev);
+
+void bme680_get_profile_dur(uint16_t *duration, const struct bme680_dev *dev);
+
+int8_t bme680_get_sensor_data(struct bme680_field_data *data, struct bme680_dev *dev);
+
+int8_t bme680_set_sensor_settings(uint16_t desired_settings, struct bme680_dev *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
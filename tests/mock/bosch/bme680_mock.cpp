@@ -0,0 +1,266 @@
+#include "bme680.h"
+
+#include "mbed_bme680_compensation.h"
+
+/*
+ * Host implementation of the Bosch API functions the library calls, see bme680.h.
+ * The register sequences follow the Bosch API v3.5.x, compensation uses BME680Compensation,
+ * which has the same integer formulas.
+ */
+
+#define RESET_PERIOD_MS 10
+#define POLL_PERIOD_MS 10
+#define POLL_TRIES 10
+
+static int8_t getRegs(uint8_t reg, uint8_t *data, uint16_t len, struct bme680_dev *dev) {
+    if (dev == NULL || dev->read == NULL)
+        return BME680_E_NULL_PTR;
+
+    dev->com_rslt = dev->read(dev->dev_id, reg, data, len);
+    return dev->com_rslt == 0 ? BME680_OK : BME680_E_COM_FAIL;
+}
+
+int8_t bme680_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint16_t len, struct bme680_dev *dev) {
+    return getRegs(reg_addr, reg_data, len, dev);
+}
+
+int8_t bme680_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint8_t len, struct bme680_dev *dev) {
+    uint8_t buffer[BME680_TMP_BUFFER_LENGTH];
+
+    if (dev == NULL || dev->write == NULL)
+        return BME680_E_NULL_PTR;
+
+    if (len == 0 || len > BME680_TMP_BUFFER_LENGTH / 2)
+        return BME680_E_INVALID_LENGTH;
+
+    /* Register/value pairs in one write, the first register is passed separately */
+    for (uint8_t i = 0; i < len; i++) {
+        buffer[2 * i] = reg_addr[i];
+        buffer[2 * i + 1] = reg_data[i];
+    }
+
+    dev->com_rslt = dev->write(dev->dev_id, buffer[0], &buffer[1], (uint16_t) (2 * len - 1));
+    return dev->com_rslt == 0 ? BME680_OK : BME680_E_COM_FAIL;
+}
+
+int8_t bme680_soft_reset(struct bme680_dev *dev) {
+    uint8_t reg = BME680_SOFT_RESET_ADDR, value = BME680_SOFT_RESET_CMD;
+    int8_t result = bme680_set_regs(&reg, &value, 1, dev);
+
+    if (result == BME680_OK)
+        dev->delay_ms(RESET_PERIOD_MS);
+
+    return result;
+}
+
+static int8_t getCalibData(struct bme680_dev *dev) {
+    uint8_t coeff[BME680_COEFF_ADDR1_LEN + BME680_COEFF_ADDR2_LEN];
+    uint8_t value;
+    int8_t result;
+
+    result = getRegs(BME680_COEFF_ADDR1, coeff, BME680_COEFF_ADDR1_LEN, dev);
+    if (result == BME680_OK)
+        result = getRegs(BME680_COEFF_ADDR2, &coeff[BME680_COEFF_ADDR1_LEN], BME680_COEFF_ADDR2_LEN, dev);
+    if (result != BME680_OK)
+        return result;
+
+    struct bme680_calib_data &calib = dev->calib;
+
+    calib.par_t1 = (uint16_t) ((coeff[34] << 8) | coeff[33]);
+    calib.par_t2 = (int16_t) ((coeff[1] << 8) | coeff[0]);
+    calib.par_t3 = (int8_t) coeff[2];
+    calib.par_p1 = (uint16_t) ((coeff[5] << 8) | coeff[4]);
+    calib.par_p2 = (int16_t) ((coeff[7] << 8) | coeff[6]);
+    calib.par_p3 = (int8_t) coeff[8];
+    calib.par_p4 = (int16_t) ((coeff[11] << 8) | coeff[10]);
+    calib.par_p5 = (int16_t) ((coeff[13] << 8) | coeff[12]);
+    calib.par_p6 = (int8_t) coeff[15];
+    calib.par_p7 = (int8_t) coeff[14];
+    calib.par_p8 = (int16_t) ((coeff[19] << 8) | coeff[18]);
+    calib.par_p9 = (int16_t) ((coeff[21] << 8) | coeff[20]);
+    calib.par_p10 = coeff[22];
+    calib.par_h1 = (uint16_t) ((coeff[27] << 4) | (coeff[26] & 0x0f));
+    calib.par_h2 = (uint16_t) ((coeff[25] << 4) | (coeff[26] >> 4));
+    calib.par_h3 = (int8_t) coeff[28];
+    calib.par_h4 = (int8_t) coeff[29];
+    calib.par_h5 = (int8_t) coeff[30];
+    calib.par_h6 = coeff[31];
+    calib.par_h7 = (int8_t) coeff[32];
+    calib.par_gh1 = (int8_t) coeff[37];
+    calib.par_gh2 = (int16_t) ((coeff[36] << 8) | coeff[35]);
+    calib.par_gh3 = (int8_t) coeff[38];
+
+    result = getRegs(BME680_ADDR_RES_HEAT_RANGE_ADDR, &value, 1, dev);
+    if (result != BME680_OK)
+        return result;
+    calib.res_heat_range = (value & 0x30) >> 4;
+
+    result = getRegs(BME680_ADDR_RES_HEAT_VAL_ADDR, &value, 1, dev);
+    if (result != BME680_OK)
+        return result;
+    calib.res_heat_val = (int8_t) value;
+
+    result = getRegs(BME680_ADDR_RANGE_SW_ERR_ADDR, &value, 1, dev);
+    if (result != BME680_OK)
+        return result;
+    calib.range_sw_err = (int8_t) ((int8_t) (value & 0xf0) / 16);
+
+    return BME680_OK;
+}
+
+int8_t bme680_init(struct bme680_dev *dev) {
+    int8_t result = bme680_soft_reset(dev);
+
+    if (result == BME680_OK)
+        result = getRegs(BME680_CHIP_ID_ADDR, &dev->chip_id, 1, dev);
+    if (result != BME680_OK)
+        return result;
+
+    if (dev->chip_id != BME680_CHIP_ID)
+        return BME680_E_DEV_NOT_FOUND;
+
+    return getCalibData(dev);
+}
+
+int8_t bme680_get_sensor_mode(struct bme680_dev *dev) {
+    uint8_t mode;
+    int8_t result = getRegs(BME680_CONF_T_P_MODE_ADDR, &mode, 1, dev);
+
+    dev->power_mode = mode & BME680_MODE_MSK;
+    return result;
+}
+
+int8_t bme680_set_sensor_mode(struct bme680_dev *dev) {
+    uint8_t reg = BME680_CONF_T_P_MODE_ADDR, value, mode;
+    int8_t result;
+
+    /* Wait for a running measurement to end, as the Bosch API does */
+    do {
+        result = getRegs(reg, &value, 1, dev);
+        if (result != BME680_OK)
+            return result;
+
+        mode = value & BME680_MODE_MSK;
+
+        if (mode != BME680_SLEEP_MODE) {
+            value &= (uint8_t) ~BME680_MODE_MSK;
+            result = bme680_set_regs(&reg, &value, 1, dev);
+            if (result != BME680_OK)
+                return result;
+            dev->delay_ms(POLL_PERIOD_MS);
+        }
+    } while (mode != BME680_SLEEP_MODE);
+
+    if (dev->power_mode != BME680_SLEEP_MODE) {
+        value = (uint8_t) ((value & ~BME680_MODE_MSK) | (dev->power_mode & BME680_MODE_MSK));
+        result = bme680_set_regs(&reg, &value, 1, dev);
+    }
+
+    return result;
+}
+
+void bme680_get_profile_dur(uint16_t *duration, const struct bme680_dev *dev) {
+    static const uint8_t cycles[6] = {0, 1, 2, 4, 8, 16};
+    uint32_t measCycles = cycles[dev->tph_sett.os_temp] + cycles[dev->tph_sett.os_pres] + cycles[dev->tph_sett.os_hum];
+    uint32_t tph = (measCycles * 1963 + 477 * 4 + 477 * 5 + 500) / 1000 + 1;
+
+    *duration = (uint16_t) tph;
+
+    if (dev->gas_sett.run_gas)
+        *duration += dev->gas_sett.heatr_dur;
+}
+
+int8_t bme680_set_sensor_settings(uint16_t desired_settings, struct bme680_dev *dev) {
+    uint8_t regs[BME680_REG_BUFFER_LENGTH + 2], values[BME680_REG_BUFFER_LENGTH + 2];
+    uint8_t count = 0, value;
+    uint8_t powerMode = dev->power_mode;
+    int8_t result;
+    BME680Compensation compensation;
+
+    compensation.load(dev->calib);
+
+    if (desired_settings & BME680_GAS_MEAS_SEL) {
+        regs[count] = BME680_RES_HEAT0_ADDR;
+        values[count++] = compensation.heaterResistance(dev->gas_sett.heatr_temp, dev->amb_temp);
+        regs[count] = BME680_GAS_WAIT0_ADDR;
+        values[count++] = BME680Compensation::heaterDuration(dev->gas_sett.heatr_dur);
+        dev->gas_sett.nb_conv = 0;
+    }
+
+    dev->power_mode = BME680_SLEEP_MODE;
+    result = bme680_set_sensor_mode(dev);
+    if (result != BME680_OK)
+        return result;
+
+    if (desired_settings & BME680_FILTER_SEL) {
+        result = getRegs(BME680_CONF_ODR_FILT_ADDR, &value, 1, dev);
+        if (result != BME680_OK)
+            return result;
+        regs[count] = BME680_CONF_ODR_FILT_ADDR;
+        values[count++] = (uint8_t) ((value & ~BME680_FILTER_MSK) | (dev->tph_sett.filter << 2));
+    }
+
+    if (desired_settings & BME680_HCNTRL_SEL) {
+        regs[count] = BME680_CONF_HEAT_CTRL_ADDR;
+        values[count++] = dev->gas_sett.heatr_ctrl & BME680_HCTRL_MSK;
+    }
+
+    if (desired_settings & (BME680_OST_SEL | BME680_OSP_SEL)) {
+        result = getRegs(BME680_CONF_T_P_MODE_ADDR, &value, 1, dev);
+        if (result != BME680_OK)
+            return result;
+        if (desired_settings & BME680_OST_SEL)
+            value = (uint8_t) ((value & ~BME680_OST_MSK) | (dev->tph_sett.os_temp << 5));
+        if (desired_settings & BME680_OSP_SEL)
+            value = (uint8_t) ((value & ~BME680_OSP_MSK) | (dev->tph_sett.os_pres << 2));
+        regs[count] = BME680_CONF_T_P_MODE_ADDR;
+        values[count++] = value;
+    }
+
+    if (desired_settings & BME680_OSH_SEL) {
+        regs[count] = BME680_CONF_OS_H_ADDR;
+        values[count++] = dev->tph_sett.os_hum & BME680_OSH_MSK;
+    }
+
+    if (desired_settings & (BME680_RUN_GAS_SEL | BME680_NBCONV_SEL)) {
+        result = getRegs(BME680_CONF_ODR_RUN_GAS_NBC_ADDR, &value, 1, dev);
+        if (result != BME680_OK)
+            return result;
+        if (desired_settings & BME680_RUN_GAS_SEL)
+            value = (uint8_t) ((value & ~BME680_RUN_GAS_MSK) | (dev->gas_sett.run_gas << 4));
+        if (desired_settings & BME680_NBCONV_SEL)
+            value = (uint8_t) ((value & ~BME680_NBCONV_MSK) | (dev->gas_sett.nb_conv & BME680_NBCONV_MSK));
+        regs[count] = BME680_CONF_ODR_RUN_GAS_NBC_ADDR;
+        values[count++] = value;
+    }
+
+    if (count > 0)
+        result = bme680_set_regs(regs, values, count, dev);
+
+    dev->power_mode = powerMode;
+    return result;
+}
+
+int8_t bme680_get_sensor_data(struct bme680_field_data *data, struct bme680_dev *dev) {
+    uint8_t raw[BME680_FIELD_LENGTH];
+    BME680Compensation compensation;
+
+    compensation.load(dev->calib);
+
+    for (uint8_t tries = 0; tries < POLL_TRIES; tries++) {
+        int8_t result = getRegs(BME680_FIELD0_ADDR, raw, BME680_FIELD_LENGTH, dev);
+
+        if (result != BME680_OK)
+            return result;
+
+        if (compensation.compensate(raw, data)) {
+            dev->new_fields = 1;
+            return BME680_OK;
+        }
+
+        dev->delay_ms(POLL_PERIOD_MS);
+    }
+
+    dev->new_fields = 0;
+    return BME680_W_NO_NEW_DATA;
+}
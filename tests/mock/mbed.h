@@ -0,0 +1,547 @@
+#ifndef BME680_MOCK_MBED_H
+#define BME680_MOCK_MBED_H
+
+/*
+ * Host stand-in for the part of the Mbed OS API used by the library.
+ * Time is virtual: it only advances with sleeps, busy waits and I2C bus traffic, so a test or benchmark
+ * measures the time a reading blocks the calling thread instead of the host scheduling.
+ * I2C transactions are routed to the devices attached with mbed_mock::attach.
+ */
+
+#include <chrono>
+#include <functional>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define MBED_SUCCESS 0
+#define MBED_ASSERT(expr) assert(expr)
+
+#define DEVICE_LPTICKER 1
+
+typedef enum {
+    NC = -1,
+    I2C_SDA = 0,
+    I2C_SCL = 1,
+} PinName;
+
+typedef enum {
+    PIN_INPUT,
+    PIN_OUTPUT
+} PinDirection;
+
+typedef enum {
+    PullNone,
+    PullUp,
+    PullDown
+} PinMode;
+
+namespace mbed_mock {
+
+/**
+ * Device on the simulated I2C bus.
+ */
+class I2CDevice {
+public:
+    virtual ~I2CDevice() {}
+
+    /**
+     * @return True if the device acknowledged all bytes
+     */
+    virtual bool write(const uint8_t *data, int length) = 0;
+
+    /**
+     * @return True if the device answered
+     */
+    virtual bool read(uint8_t *data, int length) = 0;
+};
+
+/**
+ * Traffic on the simulated I2C bus, see mbed_mock::busStats.
+ */
+struct BusStats {
+    uint32_t transactions;  // Address phases, a repeated start counts as its own transaction
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+    uint32_t nacks;
+};
+
+void attach(int address, I2CDevice *device);
+
+void detach(int address);
+
+/**
+ * Lets the next count address phases fail with a NACK
+ */
+void failNext(uint32_t count);
+
+BusStats &busStats();
+
+void resetBusStats();
+
+uint64_t nowUs();
+
+void advanceUs(uint64_t us);
+
+/**
+ * Timer interrupts and queued events, run by mbed_mock::runFor in the order they are due.
+ */
+class TimedSource {
+public:
+    virtual ~TimedSource() {}
+
+    /**
+     * @param due Receives the due time of the next event in microseconds
+     * @return True if an event is pending
+     */
+    virtual bool nextDue(uint64_t &due) = 0;
+
+    /**
+     * Runs the next event
+     */
+    virtual void runNext() = 0;
+};
+
+void addSource(TimedSource *source);
+
+void removeSource(TimedSource *source);
+
+/**
+ * Advances the virtual time by us, running the timer interrupts and queued events as they become due.
+ * Events may advance the time themselves, e.g. with I2C traffic, later events then run late.
+ */
+void runFor(uint64_t us);
+
+}
+
+inline uint32_t us_ticker_read() {
+    return (uint32_t) mbed_mock::nowUs();
+}
+
+inline void wait_us(int us) {
+    mbed_mock::advanceUs((uint64_t) us);
+}
+
+inline void core_util_critical_section_enter() {
+}
+
+inline void core_util_critical_section_exit() {
+}
+
+inline uint32_t core_util_atomic_load_u32(const volatile uint32_t *value) {
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+inline void core_util_atomic_store_u32(volatile uint32_t *value, uint32_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+}
+
+inline uint32_t core_util_atomic_incr_u32(volatile uint32_t *value, uint32_t delta) {
+    return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+}
+
+namespace mbed {
+
+template<typename T>
+class NonCopyable {
+protected:
+    NonCopyable() = default;
+    ~NonCopyable() = default;
+
+public:
+    NonCopyable(const NonCopyable &) = delete;
+    NonCopyable &operator=(const NonCopyable &) = delete;
+};
+
+template<typename F>
+class Callback;
+
+template<typename R, typename... Args>
+class Callback<R(Args...)> {
+public:
+    Callback() {}
+
+    Callback(std::nullptr_t) {}
+
+    Callback(R (*function)(Args...)) : _function(function) {}
+
+    template<typename T, typename U>
+    Callback(U *object, R (T::*method)(Args...))
+            : _function([object, method](Args... args) { return (object->*method)(args...); }) {}
+
+    template<typename F>
+    explicit Callback(F function) : _function(function) {}
+
+    R operator()(Args... args) const {
+        return _function(args...);
+    }
+
+    explicit operator bool() const {
+        return (bool) _function;
+    }
+
+private:
+    std::function<R(Args...)> _function;
+};
+
+template<typename T, typename U, typename R, typename... Args>
+Callback<R(Args...)> callback(U *object, R (T::*method)(Args...)) {
+    return Callback<R(Args...)>(object, method);
+}
+
+template<typename R, typename... Args>
+Callback<R(Args...)> callback(R (*function)(Args...)) {
+    return Callback<R(Args...)>(function);
+}
+
+template<typename T, uint32_t N>
+class CircularBuffer {
+public:
+    CircularBuffer() : _head(0), _count(0) {}
+
+    void push(const T &item) {
+        _buffer[(_head + _count) % N] = item;
+
+        if (_count < N)
+            _count++;
+        else
+            _head = (_head + 1) % N;
+    }
+
+    bool pop(T &item) {
+        if (_count == 0)
+            return false;
+
+        item = _buffer[_head];
+        _head = (_head + 1) % N;
+        _count--;
+        return true;
+    }
+
+private:
+    T _buffer[N];
+    uint32_t _head, _count;
+};
+
+/**
+ * I2C master routed to the simulated bus, the transfer time is added to the virtual time.
+ */
+class I2C {
+public:
+    I2C(PinName sda, PinName scl);
+
+    ~I2C();
+
+    void frequency(int hz);
+
+    int read(int address, char *data, int length, bool repeated = false);
+
+    int write(int address, const char *data, int length, bool repeated = false);
+
+    void stop();
+
+    void lock();
+
+    void unlock();
+
+    /**
+     * @return Number of I2C objects currently constructed on the pins, lets tests check a bus rebuild
+     */
+    static int instances();
+
+    /**
+     * @return Frequency of the last I2C object constructed or configured
+     */
+    static int lastFrequency();
+
+private:
+    int _hz;
+
+    void busTime(int bytes);
+};
+
+class DigitalInOut {
+public:
+    DigitalInOut(PinName pin, PinDirection direction, PinMode mode, int value);
+
+    int read();
+
+    void write(int value);
+
+    void output();
+
+    void input();
+
+private:
+    int _value;
+    bool _output;
+};
+
+class DeepSleepLock {
+public:
+    DeepSleepLock() {}
+};
+
+/**
+ * One shot or periodic timer interrupt on the virtual time, base of the ticker and timeout classes.
+ */
+class TimerEvent : public mbed_mock::TimedSource, private NonCopyable<TimerEvent> {
+public:
+    ~TimerEvent();
+
+    void detach();
+
+    bool nextDue(uint64_t &due);
+
+    void runNext();
+
+protected:
+    TimerEvent();
+
+    void schedule(Callback<void()> function, std::chrono::microseconds delay, bool periodic);
+
+private:
+    Callback<void()> _function;
+    uint64_t _due, _period;
+    bool _active;
+};
+
+class LowPowerTicker : public TimerEvent {
+public:
+    void attach(Callback<void()> function, std::chrono::microseconds period) {
+        schedule(function, period, true);
+    }
+};
+
+class LowPowerTimeout : public TimerEvent {
+public:
+    void attach(Callback<void()> function, std::chrono::microseconds delay) {
+        schedule(function, delay, false);
+    }
+};
+
+}
+
+namespace rtos {
+
+namespace Kernel {
+
+struct Clock {
+    typedef std::chrono::milliseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<Clock> time_point;
+    static const bool is_steady = true;
+
+    static time_point now() {
+        return time_point(duration((rep) (mbed_mock::nowUs() / 1000)));
+    }
+};
+
+}
+
+namespace ThisThread {
+
+inline void sleep_for(std::chrono::milliseconds ms) {
+    mbed_mock::advanceUs((uint64_t) ms.count() * 1000);
+}
+
+}
+
+class Mutex {
+public:
+    void lock() {}
+
+    void unlock() {}
+};
+
+class Semaphore {
+public:
+    Semaphore(int count = 0) : _count(count) {}
+
+    bool try_acquire() {
+        if (_count == 0)
+            return false;
+
+        _count--;
+        return true;
+    }
+
+    bool try_acquire_for(std::chrono::milliseconds) {
+        return try_acquire();
+    }
+
+    void release() {
+        _count++;
+    }
+
+private:
+    int _count;
+};
+
+}
+
+typedef rtos::Mutex PlatformMutex;
+
+template<typename L>
+class ScopedLock {
+public:
+    ScopedLock(L &lockable) : _lockable(lockable) {
+        _lockable.lock();
+    }
+
+    ~ScopedLock() {
+        _lockable.unlock();
+    }
+
+private:
+    L &_lockable;
+};
+
+namespace events {
+
+/**
+ * Event queue on the virtual time. Events run with mbed_mock::runFor, or with EventQueue#dispatchDue
+ * for the ones due at the current time.
+ */
+class EventQueue : public mbed_mock::TimedSource, private mbed::NonCopyable<EventQueue> {
+public:
+    EventQueue(unsigned size = 0, unsigned char *buffer = 0) : _count(0), _id(0) {
+        (void) size;
+        (void) buffer;
+        mbed_mock::addSource(this);
+    }
+
+    ~EventQueue() {
+        mbed_mock::removeSource(this);
+    }
+
+    template<typename F>
+    int call(F function) {
+        return post(0, 0, function);
+    }
+
+    template<typename F>
+    int call_in(std::chrono::milliseconds delay, F function) {
+        return post((uint64_t) delay.count() * 1000, 0, function);
+    }
+
+    template<typename F>
+    int call_every(std::chrono::milliseconds period, F function) {
+        uint64_t us = (uint64_t) period.count() * 1000;
+
+        return post(us, us, function);
+    }
+
+    bool cancel(int id) {
+        for (int i = 0; i < _count; i++) {
+            if (_events[i].id == id) {
+                _events[i] = _events[--_count];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Runs the events that are due at the current virtual time
+     * @return Number of dispatched events
+     */
+    int dispatchDue() {
+        int dispatched = 0;
+        uint64_t due;
+
+        while (nextDue(due) && due <= mbed_mock::nowUs()) {
+            runNext();
+            dispatched++;
+        }
+
+        return dispatched;
+    }
+
+    /**
+     * @return Number of pending events, periodic ones included
+     */
+    int pending() const {
+        return _count;
+    }
+
+    bool nextDue(uint64_t &due) {
+        int next = earliest();
+
+        if (next < 0)
+            return false;
+
+        due = _events[next].due;
+        return true;
+    }
+
+    void runNext() {
+        int next = earliest();
+
+        if (next < 0)
+            return;
+
+        std::function<void()> function = _events[next].function;
+
+        if (_events[next].period > 0)
+            _events[next].due += _events[next].period;
+        else
+            _events[next] = _events[--_count];
+
+        function();
+    }
+
+private:
+    static const int MAX_EVENTS = 8;
+
+    struct Event {
+        int id;
+        uint64_t due, period;
+        std::function<void()> function;
+    };
+
+    Event _events[MAX_EVENTS];
+    int _count;
+    int _id;
+
+    template<typename F>
+    int post(uint64_t delay, uint64_t period, F function) {
+        if (_count >= MAX_EVENTS)
+            return 0;
+
+        _events[_count].id = ++_id;
+        _events[_count].due = mbed_mock::nowUs() + delay;
+        _events[_count].period = period;
+        _events[_count].function = function;
+        _count++;
+        return _id;
+    }
+
+    /* Ties run in posting order */
+    int earliest() const {
+        int next = -1;
+
+        for (int i = 0; i < _count; i++) {
+            if (next < 0 || _events[i].due < _events[next].due
+                || (_events[i].due == _events[next].due && _events[i].id < _events[next].id))
+                next = i;
+        }
+
+        return next;
+    }
+};
+
+}
+
+using namespace mbed;
+using namespace rtos;
+using namespace events;
+using namespace std::chrono_literals;
+
+#endif
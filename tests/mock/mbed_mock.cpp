@@ -0,0 +1,251 @@
+#include "mbed.h"
+
+namespace mbed_mock {
+
+static const int MAX_DEVICES = 8;
+
+static struct {
+    int address;
+    I2CDevice *device;
+} devices[MAX_DEVICES];
+
+static BusStats stats;
+static uint32_t failures;
+static uint64_t now;
+
+void attach(int address, I2CDevice *device) {
+    detach(address);
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (devices[i].device == NULL) {
+            devices[i].address = address;
+            devices[i].device = device;
+            return;
+        }
+    }
+
+    assert(false);
+}
+
+void detach(int address) {
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (devices[i].device != NULL && devices[i].address == address)
+            devices[i].device = NULL;
+    }
+}
+
+void failNext(uint32_t count) {
+    failures = count;
+}
+
+BusStats &busStats() {
+    return stats;
+}
+
+void resetBusStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint64_t nowUs() {
+    return now;
+}
+
+void advanceUs(uint64_t us) {
+    now += us;
+}
+
+static const int MAX_SOURCES = 16;
+static TimedSource *sources[MAX_SOURCES];
+
+void addSource(TimedSource *source) {
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        if (sources[i] == NULL) {
+            sources[i] = source;
+            return;
+        }
+    }
+
+    assert(false);
+}
+
+void removeSource(TimedSource *source) {
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        if (sources[i] == source)
+            sources[i] = NULL;
+    }
+}
+
+void runFor(uint64_t us) {
+    uint64_t end = now + us;
+
+    for (;;) {
+        TimedSource *next = NULL;
+        uint64_t nextDue = 0, due;
+
+        for (int i = 0; i < MAX_SOURCES; i++) {
+            if (sources[i] != NULL && sources[i]->nextDue(due) && (next == NULL || due < nextDue)) {
+                next = sources[i];
+                nextDue = due;
+            }
+        }
+
+        if (next == NULL || nextDue > end)
+            break;
+
+        if (nextDue > now)
+            now = nextDue;
+
+        next->runNext();
+    }
+
+    if (end > now)
+        now = end;
+}
+
+/**
+ * Address phase, NULL if nobody acknowledges the address
+ */
+static I2CDevice *select(int address) {
+    stats.transactions++;
+
+    if (failures > 0) {
+        failures--;
+        stats.nacks++;
+        return NULL;
+    }
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (devices[i].device != NULL && devices[i].address == (address & ~1))
+            return devices[i].device;
+    }
+
+    stats.nacks++;
+    return NULL;
+}
+
+}
+
+static int i2cInstances;
+static int i2cFrequency = 100000;
+
+I2C::I2C(PinName sda, PinName scl) : _hz(100000) {
+    (void) sda;
+    (void) scl;
+    i2cInstances++;
+    i2cFrequency = _hz;
+}
+
+I2C::~I2C() {
+    i2cInstances--;
+}
+
+void I2C::frequency(int hz) {
+    _hz = hz;
+    i2cFrequency = hz;
+}
+
+int I2C::read(int address, char *data, int length, bool repeated) {
+    (void) repeated;
+    mbed_mock::I2CDevice *device = mbed_mock::select(address);
+
+    busTime(length + 1);
+
+    if (device == NULL || !device->read((uint8_t *) data, length))
+        return 1;
+
+    mbed_mock::stats.bytesRead += length;
+    return 0;
+}
+
+int I2C::write(int address, const char *data, int length, bool repeated) {
+    (void) repeated;
+    mbed_mock::I2CDevice *device = mbed_mock::select(address);
+
+    busTime(length + 1);
+
+    if (device == NULL || !device->write((const uint8_t *) data, length))
+        return 1;
+
+    mbed_mock::stats.bytesWritten += length;
+    return 0;
+}
+
+void I2C::stop() {
+}
+
+void I2C::lock() {
+}
+
+void I2C::unlock() {
+}
+
+int I2C::instances() {
+    return i2cInstances;
+}
+
+int I2C::lastFrequency() {
+    return i2cFrequency;
+}
+
+/**
+ * Advances the virtual time by 9 bit times per byte, start and stop conditions included
+ */
+void I2C::busTime(int bytes) {
+    mbed_mock::advanceUs(((uint64_t) bytes * 9 + 2) * 1000000 / _hz);
+}
+
+DigitalInOut::DigitalInOut(PinName pin, PinDirection direction, PinMode mode, int value)
+        : _value(value), _output(direction == PIN_OUTPUT) {
+    (void) pin;
+    (void) mode;
+}
+
+int DigitalInOut::read() {
+    /* Released lines are pulled high, nothing holds the simulated bus */
+    return _output ? _value : 1;
+}
+
+void DigitalInOut::write(int value) {
+    _value = value;
+}
+
+void DigitalInOut::output() {
+    _output = true;
+}
+
+void DigitalInOut::input() {
+    _output = false;
+}
+
+TimerEvent::TimerEvent() : _due(0), _period(0), _active(false) {
+    mbed_mock::addSource(this);
+}
+
+TimerEvent::~TimerEvent() {
+    mbed_mock::removeSource(this);
+}
+
+void TimerEvent::schedule(Callback<void()> function, std::chrono::microseconds delay, bool periodic) {
+    _function = function;
+    _due = mbed_mock::nowUs() + (uint64_t) delay.count();
+    _period = periodic ? (uint64_t) delay.count() : 0;
+    _active = true;
+}
+
+void TimerEvent::detach() {
+    _active = false;
+}
+
+bool TimerEvent::nextDue(uint64_t &due) {
+    due = _due;
+    return _active;
+}
+
+void TimerEvent::runNext() {
+    if (_period > 0)
+        _due += _period;
+    else
+        _active = false;
+
+    _function();
+}
@@ -0,0 +1,49 @@
+#ifndef BME680_TEST_H
+#define BME680_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Minimal assertions for the host tests, a failed check is reported and the test continues.
+ * Each test program calls its test functions with RUN and returns TEST_RESULT from main.
+ */
+
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        long long e_ = (long long) (expected), a_ = (long long) (actual); \
+        if (e_ != a_) { \
+            printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, e_, a_); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+    do { \
+        double e_ = (double) (expected), a_ = (double) (actual); \
+        if (!(e_ - a_ <= (tolerance) && a_ - e_ <= (tolerance))) { \
+            printf("%s:%d: %s ~ %s failed: %g != %g\n", __FILE__, __LINE__, #expected, #actual, e_, a_); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define RUN(test) \
+    do { \
+        int before_ = testFailures; \
+        test(); \
+        printf("%s %s\n", testFailures == before_ ? "PASS" : "FAIL", #test); \
+    } while (0)
+
+#define TEST_RESULT (testFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif
@@ -0,0 +1,167 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_batch.h"
+
+static void rawBlock(uint8_t raw[BME680_FIELD_LENGTH], uint32_t temp, uint32_t pres, uint16_t hum, uint16_t gas,
+                     uint8_t range) {
+    memset(raw, 0, BME680_FIELD_LENGTH);
+    raw[0] = BME680_NEW_DATA_MSK;
+    raw[2] = (uint8_t) (pres >> 12);
+    raw[3] = (uint8_t) (pres >> 4);
+    raw[4] = (uint8_t) (pres << 4);
+    raw[5] = (uint8_t) (temp >> 12);
+    raw[6] = (uint8_t) (temp >> 4);
+    raw[7] = (uint8_t) (temp << 4);
+    raw[8] = (uint8_t) (hum >> 8);
+    raw[9] = (uint8_t) hum;
+    raw[13] = (uint8_t) (gas >> 2);
+    raw[14] = (uint8_t) ((gas << 6) | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK | range);
+}
+
+static BME680Compensation loaded() {
+    BME680Compensation compensation;
+
+    compensation.load(BME680Simulator::calibration());
+    return compensation;
+}
+
+static void testCapacity() {
+    BME680Batch<3> batch;
+    uint8_t raw[BME680_FIELD_LENGTH];
+    struct bme680_field_data data = {};
+
+    rawBlock(raw, 494000, 355000, 20300, 680, 7);
+
+    CHECK_EQUAL(3, batch.capacity());
+    CHECK(batch.addRaw(raw));
+    CHECK(batch.add(data));
+    CHECK(batch.addRaw(raw));
+    CHECK(!batch.addRaw(raw));
+    CHECK(!batch.add(data));
+    CHECK_EQUAL(3, batch.size());
+
+    batch.clear();
+    CHECK_EQUAL(0, batch.size());
+}
+
+static void testCompensateRaw() {
+    BME680Compensation compensation = loaded();
+    BME680Batch<16> batch;
+    uint8_t raw[16][BME680_FIELD_LENGTH];
+
+    for (uint8_t i = 0; i < 16; i++) {
+        rawBlock(raw[i], 450000 + i * 5000, 300000 + i * 8000, (uint16_t) (18000 + i * 700), (uint16_t) (i * 60), i);
+        CHECK(batch.addRaw(raw[i]));
+    }
+
+    batch.compensate(compensation);
+
+    /* Same results as the per sample path */
+    for (uint8_t i = 0; i < 16; i++) {
+        struct bme680_field_data data;
+
+        CHECK(compensation.compensate(raw[i], &data));
+        CHECK_EQUAL(data.status, batch.getStatus()[i]);
+        CHECK_EQUAL(data.temperature, batch.getTemperatures()[i]);
+        CHECK_EQUAL(data.pressure, batch.getPressures()[i]);
+        CHECK_EQUAL(data.humidity, batch.getHumidities()[i]);
+        CHECK_EQUAL(data.gas_resistance, batch.getGasResistances()[i]);
+    }
+}
+
+static void testCompensateFrom() {
+    BME680Compensation compensation = loaded();
+    BME680Batch<4> batch;
+    uint8_t raw[BME680_FIELD_LENGTH];
+    struct bme680_field_data data = {};
+
+    data.status = BME680_NEW_DATA_MSK;
+    data.temperature = 1999;
+    data.pressure = 99999;
+    data.humidity = 55555;
+    data.gas_resistance = 77777;
+
+    /* Compensated samples first, raw samples compensated from their index on */
+    batch.add(data);
+    rawBlock(raw, 494000, 355000, 20300, 680, 7);
+    batch.addRaw(raw);
+    batch.compensate(compensation, 1);
+
+    CHECK_EQUAL(1999, batch.getTemperatures()[0]);
+    CHECK_EQUAL(99999, batch.getPressures()[0]);
+    CHECK_EQUAL(55555, batch.getHumidities()[0]);
+    CHECK_EQUAL(77777, batch.getGasResistances()[0]);
+
+    CHECK(compensation.compensate(raw, &data));
+    CHECK_EQUAL(data.temperature, batch.getTemperatures()[1]);
+    CHECK_EQUAL(data.gas_resistance, batch.getGasResistances()[1]);
+
+    /* A start past the end does nothing */
+    batch.compensate(compensation, 5);
+    CHECK_EQUAL(data.temperature, batch.getTemperatures()[1]);
+}
+
+static void testCompensateMixed() {
+    BME680Compensation compensation = loaded();
+    BME680Batch<5> batch;
+    uint8_t raw[BME680_FIELD_LENGTH];
+    struct bme680_field_data data = {}, expected;
+
+    data.temperature = 1999;
+    data.gas_resistance = 77777;
+    rawBlock(raw, 494000, 355000, 20300, 680, 7);
+    CHECK(compensation.compensate(raw, &expected));
+
+    /* Compensated samples between raw ones keep their values */
+    batch.addRaw(raw);
+    batch.add(data);
+    batch.addRaw(raw);
+    batch.addRaw(raw);
+    batch.add(data);
+    batch.compensate(compensation);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        bool added = i == 1 || i == 4;
+
+        CHECK_EQUAL(added ? 1999 : expected.temperature, batch.getTemperatures()[i]);
+        CHECK_EQUAL(added ? 77777 : expected.gas_resistance, batch.getGasResistances()[i]);
+    }
+}
+
+static void testConvert() {
+    BME680Batch<2> batch;
+    struct bme680_field_data data = {};
+    float celsius[2], pascal[2], percent[2], ohm[2];
+
+    data.temperature = -1234;
+    data.pressure = 101325;
+    data.humidity = 45678;
+    data.gas_resistance = 123456;
+    batch.add(data);
+    data.temperature = 2500;
+    batch.add(data);
+
+    batch.convert(celsius, pascal, percent, ohm);
+
+    CHECK_NEAR(-12.34, celsius[0], 1e-4);
+    CHECK_NEAR(25.0, celsius[1], 1e-4);
+    CHECK_NEAR(101325.0, pascal[0], 1e-2);
+    CHECK_NEAR(45.678, percent[0], 1e-4);
+    CHECK_NEAR(123456.0, ohm[1], 1e-2);
+
+    /* Outputs may be left out */
+    celsius[0] = 0;
+    batch.convert(NULL, pascal, NULL, NULL);
+    CHECK_EQUAL(0, celsius[0]);
+}
+
+int main() {
+    RUN(testCapacity);
+    RUN(testCompensateRaw);
+    RUN(testCompensateFrom);
+    RUN(testCompensateMixed);
+    RUN(testConvert);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,94 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_bus.h"
+
+/*
+ * BME680Bus with two simulated sensors: parallel readings and the recovery of failed sensors.
+ */
+
+static void testReadings() {
+    BME680Simulator first(0x76 << 1), second(0x77 << 1);
+    BME680Bus bus(I2C_SDA, I2C_SCL);
+    BME680 a(0x76 << 1, bus.getI2C()), b(0x77 << 1, bus.getI2C());
+
+    CHECK(a.begin());
+    CHECK(b.begin());
+    CHECK(bus.attach(a));
+    CHECK(bus.attach(b));
+    CHECK(!bus.attach(a));
+    CHECK_EQUAL(2, bus.getSensorCount());
+
+    CHECK_EQUAL(3, bus.performReadings());
+    CHECK_EQUAL(1, first.measurements());
+    CHECK_EQUAL(1, second.measurements());
+
+    /* With the settings written, both conversions run during one sleep */
+    uint64_t start = mbed_mock::nowUs();
+
+    CHECK_EQUAL(3, bus.performReadings());
+    CHECK(mbed_mock::nowUs() - start < (uint64_t) a.getProfileDuration() * 1000 + 10000);
+    CHECK_EQUAL(0, bus.getBusClears());
+}
+
+static void testMissedReading() {
+    BME680Simulator first(0x76 << 1), second(0x77 << 1);
+    BME680Bus bus(I2C_SDA, I2C_SCL);
+    BME680 a(0x76 << 1, bus.getI2C()), b(0x77 << 1, bus.getI2C());
+
+    CHECK(a.begin());
+    CHECK(b.begin());
+    bus.attach(a);
+    bus.attach(b);
+    CHECK_EQUAL(3, bus.performReadings());
+    a.resetStats();
+    b.resetStats();
+
+    /* The first sensor misses its trigger but still answers, only it is recovered and the bus is left alone */
+    mbed_mock::failNext(BME680_I2C_RETRIES + 1);
+    CHECK_EQUAL(2, bus.performReadings());
+    CHECK_EQUAL(1, a.getStats().recoveries);
+    CHECK_EQUAL(0, b.getStats().recoveries);
+    CHECK_EQUAL(0, bus.getBusClears());
+
+    CHECK_EQUAL(3, bus.performReadings());
+}
+
+static void testLostSensor() {
+    BME680Simulator first(0x76 << 1), second(0x77 << 1);
+    BME680Bus bus(I2C_SDA, I2C_SCL);
+    BME680 a(0x76 << 1, bus.getI2C()), b(0x77 << 1, bus.getI2C());
+
+    bus.frequency(400000);
+    CHECK(a.begin());
+    CHECK(b.begin());
+    bus.attach(a);
+    bus.attach(b);
+    CHECK_EQUAL(3, bus.performReadings());
+    a.resetStats();
+    b.resetStats();
+
+    /* A sensor without its chip ID gets the bus cleared, the bus keeps its frequency */
+    second.setPresent(false);
+    CHECK_EQUAL(1, bus.performReadings());
+    CHECK_EQUAL(1, bus.getBusClears());
+    CHECK_EQUAL(400000, I2C::lastFrequency());
+    CHECK_EQUAL(0, a.getStats().recoveries);
+    CHECK_EQUAL(2, b.getStats().recoveries);
+
+    /* Once it answers again it is reinitialized */
+    second.setPresent(true);
+    second.powerCycle();
+    CHECK(bus.recover(2));
+    CHECK_EQUAL(1, b.getStats().reinits);
+    CHECK_EQUAL(3, bus.performReadings());
+    CHECK_EQUAL(BME680_OS_2X, second.reg(BME680_CONF_OS_H_ADDR));
+}
+
+int main() {
+    RUN(testReadings);
+    RUN(testMissedReading);
+    RUN(testLostSensor);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,92 @@
+#include "test.h"
+
+#include "mbed_bme680_change_detector.h"
+
+#define STABLE (BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK)
+
+static BME680Sample sample(uint32_t timestamp, int16_t temperature, uint32_t gasResistance, uint8_t status = STABLE) {
+    BME680Sample result;
+
+    result.timestamp = timestamp;
+    result.data = bme680_field_data();
+    result.data.status = status;
+    result.data.temperature = temperature;
+    result.data.pressure = 100000;
+    result.data.humidity = 40000;
+    result.data.gas_resistance = gasResistance;
+    return result;
+}
+
+static uint32_t reports;
+static uint8_t lastReasons;
+
+static void onReport(const BME680Sample &, uint8_t reasons) {
+    reports++;
+    lastReasons = reasons;
+}
+
+static void testDeadband() {
+    BME680ChangeDetector detector;
+
+    detector.attach(callback(onReport));
+    reports = 0;
+
+    /* The first sample is reported for all channels */
+    CHECK_EQUAL(BME680_CHANGE_TEMPERATURE | BME680_CHANGE_PRESSURE | BME680_CHANGE_HUMIDITY | BME680_CHANGE_GAS,
+                detector.update(sample(0, 2500, 50000)));
+    CHECK_EQUAL(1, reports);
+
+    /* Small steps don't add up against the last reported sample */
+    CHECK_EQUAL(0, detector.update(sample(1000, 2506, 51000)));
+    CHECK_EQUAL(0, detector.update(sample(2000, 2510, 52000)));
+    CHECK_EQUAL(BME680_CHANGE_TEMPERATURE, detector.update(sample(3000, 2511, 52000)));
+    CHECK_EQUAL(BME680_CHANGE_TEMPERATURE, lastReasons);
+
+    CHECK_EQUAL(0, detector.update(sample(4000, 2501, 52000)));
+    CHECK_EQUAL(BME680_CHANGE_TEMPERATURE, detector.update(sample(5000, 2500, 52000)));
+    CHECK_EQUAL(BME680_CHANGE_GAS, detector.update(sample(6000, 2500, 47400)));
+
+    CHECK_EQUAL(4, detector.getReported());
+    CHECK_EQUAL(3, detector.getSuppressed());
+    CHECK_EQUAL(4, reports);
+}
+
+static void testGasReference() {
+    BME680ChangeDetector detector;
+
+    detector.update(sample(0, 2500, 50000));
+
+    /* Readings without a stable gas value are not compared and keep the gas reference */
+    CHECK_EQUAL(BME680_CHANGE_TEMPERATURE, detector.update(sample(1000, 2600, 1, BME680_NEW_DATA_MSK)));
+    CHECK_EQUAL(0, detector.update(sample(2000, 2600, 52000)));
+    CHECK_EQUAL(BME680_CHANGE_GAS, detector.update(sample(3000, 2600, 53000)));
+
+    detector.reset();
+    CHECK(detector.update(sample(4000, 2600, 53000)) & BME680_CHANGE_GAS);
+}
+
+static void testHeartbeat() {
+    BME680ChangeDetector detector;
+
+    detector.setHeartbeat(std::chrono::milliseconds(10000));
+    detector.update(sample(0, 2500, 50000));
+
+    CHECK_EQUAL(0, detector.update(sample(9999, 2500, 50000)));
+    CHECK_EQUAL(BME680_CHANGE_HEARTBEAT, detector.update(sample(10000, 2500, 50000)));
+
+    /* The heartbeat restarts with every report, also across a timestamp wrap */
+    detector.update(sample(UINT32_MAX - 1000, 2600, 50000));
+    CHECK_EQUAL(0, detector.update(sample(8000, 2600, 50000)));
+    CHECK_EQUAL(BME680_CHANGE_HEARTBEAT, detector.update(sample(9000, 2600, 50000)));
+
+    detector.setHeartbeat(std::chrono::milliseconds(0));
+    CHECK_EQUAL(0, detector.update(sample(100000, 2600, 50000)));
+}
+
+int main() {
+    RUN(testDeadband);
+    RUN(testGasReference);
+    RUN(testHeartbeat);
+
+    return TEST_RESULT;
+}
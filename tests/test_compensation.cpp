@@ -0,0 +1,245 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_compensation.h"
+
+/*
+ * Compares the integer compensation with the floating point formulas of the BME680 datasheet.
+ */
+
+static const struct bme680_calib_data calib = BME680Simulator::calibration();
+
+static double referenceTFine(uint32_t adc) {
+    double var1 = ((double) adc / 16384.0 - calib.par_t1 / 1024.0) * calib.par_t2;
+    double var2 = ((double) adc / 131072.0 - calib.par_t1 / 8192.0);
+
+    return var1 + var2 * var2 * (calib.par_t3 * 16.0);
+}
+
+static double referencePressure(uint32_t adc, double tFine) {
+    double var1 = tFine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * (calib.par_p6 / 131072.0);
+    var2 = var2 + var1 * calib.par_p5 * 2.0;
+    var2 = var2 / 4.0 + calib.par_p4 * 65536.0;
+    var1 = ((calib.par_p3 * var1 * var1) / 16384.0 + calib.par_p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * calib.par_p1;
+
+    double pressure = 1048576.0 - adc;
+    pressure = ((pressure - var2 / 4096.0) * 6250.0) / var1;
+    var1 = calib.par_p9 * pressure * pressure / 2147483648.0;
+    var2 = pressure * (calib.par_p8 / 32768.0);
+    double var3 = (pressure / 256.0) * (pressure / 256.0) * (pressure / 256.0) * (calib.par_p10 / 131072.0);
+
+    return pressure + (var1 + var2 + var3 + calib.par_p7 * 128.0) / 16.0;
+}
+
+static double referenceHumidity(uint16_t adc, double tFine) {
+    double temperature = tFine / 5120.0;
+    double var1 = adc - (calib.par_h1 * 16.0 + (calib.par_h3 / 2.0) * temperature);
+    double var2 = var1 * ((calib.par_h2 / 262144.0) * (1.0 + (calib.par_h4 / 16384.0) * temperature
+                                                        + (calib.par_h5 / 1048576.0) * temperature * temperature));
+    double var3 = calib.par_h6 / 16384.0;
+    double var4 = calib.par_h7 / 2097152.0;
+    double humidity = var2 + (var3 + var4 * temperature) * var2 * var2;
+
+    return humidity > 100.0 ? 100.0 : humidity < 0.0 ? 0.0 : humidity;
+}
+
+static double referenceGas(uint16_t adc, uint8_t range) {
+    static const double k1[16] = {0, 0, 0, 0, 0, -1, 0, -0.8, 0, 0, -0.2, -0.5, 0, -1, 0, 0};
+    static const double k2[16] = {0, 0, 0, 0, 0.1, 0.7, 0, -0.8, -0.1, 0, 0, 0, 0, 0, 0, 0};
+    double var1 = 1340.0 + 5.0 * calib.range_sw_err;
+    double var2 = var1 * (1.0 + k1[range] / 100.0);
+    double var3 = 1.0 + k2[range] / 100.0;
+
+    return 1.0 / (var3 * 0.000000125 * (double) (1 << range) * ((adc - 512.0) / var2 + 1.0));
+}
+
+static BME680Compensation loaded() {
+    BME680Compensation compensation;
+
+    compensation.load(calib);
+    return compensation;
+}
+
+static void testNotLoaded() {
+    BME680Compensation compensation;
+
+    CHECK(!compensation.isLoaded());
+    CHECK(loaded().isLoaded());
+}
+
+static void testTemperature() {
+    BME680Compensation compensation = loaded();
+    int32_t tFine;
+
+    for (uint32_t adc = 400000; adc <= 600000; adc += 5000) {
+        int16_t temperature = compensation.temperature(adc, &tFine);
+
+        CHECK_NEAR(referenceTFine(adc) / 5120.0, temperature / 100.0, 0.011);
+        CHECK_NEAR(referenceTFine(adc), tFine, 8);
+    }
+}
+
+static void testPressure() {
+    BME680Compensation compensation = loaded();
+    int32_t tFine;
+
+    for (uint32_t tempAdc = 450000; tempAdc <= 550000; tempAdc += 50000) {
+        compensation.temperature(tempAdc, &tFine);
+
+        /* The integer formula of the Bosch API overflows its cubic term above about 1050 hPa with this
+         * calibration, the comparison stays below that */
+        for (uint32_t adc = 250000; adc <= 500000; adc += 10000) {
+            double reference = referencePressure(adc, referenceTFine(tempAdc));
+
+            if (reference < 105000)
+                CHECK_NEAR(reference, compensation.pressure(adc, tFine), 8);
+        }
+    }
+}
+
+static void testHumidity() {
+    BME680Compensation compensation = loaded();
+    int32_t tFine;
+
+    for (uint32_t tempAdc = 450000; tempAdc <= 550000; tempAdc += 50000) {
+        compensation.temperature(tempAdc, &tFine);
+
+        for (uint32_t adc = 12000; adc <= 40000; adc += 1000)
+            CHECK_NEAR(referenceHumidity(adc, referenceTFine(tempAdc)), compensation.humidity(adc, tFine) / 1000.0,
+                       0.05);
+    }
+
+    /* Out of range ADC values are limited to 0 and 100 %RH */
+    compensation.temperature(494000, &tFine);
+    CHECK_EQUAL(0, compensation.humidity(0, tFine));
+    CHECK_EQUAL(100000, compensation.humidity(65535, tFine));
+}
+
+static void testGasResistance() {
+    BME680Compensation compensation = loaded();
+
+    for (uint8_t range = 0; range < 16; range++) {
+        for (uint16_t adc = 0; adc < 1024; adc += 31) {
+            double expected = referenceGas(adc, range);
+
+            CHECK_NEAR(expected, compensation.gasResistance(adc, range), expected * 0.005 + 1);
+        }
+    }
+}
+
+static void testCompensateBlock() {
+    BME680Compensation compensation = loaded();
+    struct bme680_field_data data;
+    uint8_t raw[BME680_FIELD_LENGTH] = {0};
+    int32_t tFine;
+
+    /* New data, gas index 3, gas 680 in range 7, valid and stable */
+    raw[0] = BME680_NEW_DATA_MSK | 3;
+    raw[1] = 7;
+    raw[2] = 355000 >> 12;
+    raw[3] = (uint8_t) (355000 >> 4);
+    raw[4] = (uint8_t) (355000 << 4);
+    raw[5] = 494000 >> 12;
+    raw[6] = (uint8_t) (494000 >> 4);
+    raw[7] = (uint8_t) (494000 << 4);
+    raw[8] = 20300 >> 8;
+    raw[9] = (uint8_t) 20300;
+    raw[13] = 680 >> 2;
+    raw[14] = (uint8_t) ((680 << 6) | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK | 7);
+
+    CHECK(compensation.compensate(raw, &data));
+    CHECK_EQUAL(BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK, data.status);
+    CHECK_EQUAL(3, data.gas_index);
+    CHECK_EQUAL(7, data.meas_index);
+    CHECK_EQUAL(compensation.temperature(494000, &tFine), data.temperature);
+    CHECK_EQUAL(compensation.pressure(355000, tFine), data.pressure);
+    CHECK_EQUAL(compensation.humidity(20300, tFine), data.humidity);
+    CHECK_EQUAL(compensation.gasResistance(680, 7), data.gas_resistance);
+
+    /* The default simulator values are a plausible indoor climate */
+    CHECK_NEAR(2500, data.temperature, 100);
+    CHECK_NEAR(100000, data.pressure, 3000);
+    CHECK_NEAR(40000, data.humidity, 10000);
+
+    /* Without new data the previous values are kept, the status included */
+    struct bme680_field_data previous = data;
+
+    raw[0] = 0;
+    raw[1] = 8;
+    raw[14] = 0;
+    CHECK(!compensation.compensate(raw, &data));
+    CHECK_EQUAL(previous.status, data.status);
+    CHECK_EQUAL(previous.gas_index, data.gas_index);
+    CHECK_EQUAL(previous.meas_index, data.meas_index);
+    CHECK_EQUAL(previous.temperature, data.temperature);
+    CHECK_EQUAL(previous.pressure, data.pressure);
+    CHECK_EQUAL(previous.humidity, data.humidity);
+    CHECK_EQUAL(previous.gas_resistance, data.gas_resistance);
+}
+
+static void testColumnKernels() {
+    BME680Compensation compensation = loaded();
+    const size_t count = 37;
+    uint32_t tempAdc[count], presAdc[count];
+    uint16_t humAdc[count], gasAdc[count];
+    uint8_t gasRange[count];
+    int32_t tFine[count];
+    int16_t temperature[count];
+    uint32_t pressure[count], humidity[count], gas[count];
+
+    for (size_t i = 0; i < count; i++) {
+        tempAdc[i] = 450000 + i * 2500;
+        presAdc[i] = 300000 + i * 4000;
+        humAdc[i] = (uint16_t) (15000 + i * 500);
+        gasAdc[i] = (uint16_t) (i * 27);
+        gasRange[i] = (uint8_t) (i % 16);
+    }
+
+    compensation.temperatures(tempAdc, tFine, temperature, count);
+    compensation.pressures(presAdc, tFine, pressure, count);
+    compensation.humidities(humAdc, tFine, humidity, count);
+    compensation.gasResistances(gasAdc, gasRange, gas, count);
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t expectedTFine;
+
+        CHECK_EQUAL(compensation.temperature(tempAdc[i], &expectedTFine), temperature[i]);
+        CHECK_EQUAL(expectedTFine, tFine[i]);
+        CHECK_EQUAL(compensation.pressure(presAdc[i], expectedTFine), pressure[i]);
+        CHECK_EQUAL(compensation.humidity(humAdc[i], expectedTFine), humidity[i]);
+        CHECK_EQUAL(compensation.gasResistance(gasAdc[i], gasRange[i]), gas[i]);
+    }
+}
+
+static void testHeaterDuration() {
+    CHECK_EQUAL(1, BME680Compensation::heaterDuration(1));
+    CHECK_EQUAL(63, BME680Compensation::heaterDuration(63));
+    CHECK_EQUAL(0x40 | 37, BME680Compensation::heaterDuration(150));
+    CHECK_EQUAL(0xc0 | 62, BME680Compensation::heaterDuration(4000));
+    CHECK_EQUAL(0xff, BME680Compensation::heaterDuration(4032));
+}
+
+static void testHeaterResistance() {
+    BME680Compensation compensation = loaded();
+
+    /* Hotter set-points need a larger heater resistance, the limit is 400 degC */
+    CHECK(compensation.heaterResistance(200, 25) < compensation.heaterResistance(320, 25));
+    CHECK(compensation.heaterResistance(320, 25) < compensation.heaterResistance(400, 25));
+    CHECK_EQUAL(compensation.heaterResistance(400, 25), compensation.heaterResistance(450, 25));
+}
+
+int main() {
+    RUN(testNotLoaded);
+    RUN(testTemperature);
+    RUN(testPressure);
+    RUN(testHumidity);
+    RUN(testGasResistance);
+    RUN(testCompensateBlock);
+    RUN(testColumnKernels);
+    RUN(testHeaterDuration);
+    RUN(testHeaterResistance);
+
+    return TEST_RESULT;
+}
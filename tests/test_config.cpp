@@ -0,0 +1,100 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680.h"
+
+/*
+ * Compile time configurations: the register image and its use by BME680#applyConfig.
+ */
+
+typedef BME680Config<BME680_OS_2X, BME680_OS_4X, BME680_OS_1X, BME680_FILTER_SIZE_7, BME680Heater<300, 100>> Config;
+typedef BME680Config<BME680_OS_1X, BME680_OS_1X, BME680_OS_1X, BME680_FILTER_SIZE_0> NoGasConfig;
+
+static void testImage() {
+    const BME680RegisterImage &image = Config::image;
+
+    CHECK_EQUAL(BME680_OS_1X, image.ctrlHum);
+    CHECK_EQUAL((BME680_OS_2X << 5) | (BME680_OS_4X << 2), image.ctrlMeas);
+    CHECK_EQUAL(BME680_FILTER_SIZE_7 << 2, image.config);
+    CHECK_EQUAL(BME680_RUN_GAS_MSK, image.ctrlGas1);
+    CHECK_EQUAL(BME680Compensation::heaterDuration(100), image.gasWait0);
+    CHECK_EQUAL(19, image.tphDuration);
+    CHECK_EQUAL(119, image.profileDuration);
+
+    CHECK_EQUAL(0, NoGasConfig::image.ctrlGas1);
+    CHECK_EQUAL(NoGasConfig::image.tphDuration, NoGasConfig::image.profileDuration);
+}
+
+static void testApply() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680Compensation compensation;
+
+    CHECK(!sensor.applyConfig(Config::image));
+    CHECK(sensor.begin());
+
+    /* The whole image is one write transaction */
+    mbed_mock::resetBusStats();
+    CHECK(sensor.applyConfig(Config::image));
+    CHECK_EQUAL(1, mbed_mock::busStats().transactions);
+
+    compensation.load(BME680Simulator::calibration());
+    CHECK_EQUAL(Config::image.ctrlHum, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK_EQUAL(Config::image.ctrlMeas, simulator.reg(BME680_CONF_T_P_MODE_ADDR));
+    CHECK_EQUAL(Config::image.config, simulator.reg(BME680_CONF_ODR_FILT_ADDR));
+    CHECK_EQUAL(Config::image.gasWait0, simulator.reg(BME680_GAS_WAIT0_ADDR));
+    CHECK_EQUAL(compensation.heaterResistance(300, 25), simulator.reg(BME680_RES_HEAT0_ADDR));
+    CHECK_EQUAL(Config::image.profileDuration, sensor.getProfileDuration());
+
+    /* The readings don't write the covered settings again */
+    uint32_t writes = simulator.writes(BME680_CONF_OS_H_ADDR);
+
+    CHECK(sensor.performReading());
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(writes, simulator.writes(BME680_CONF_OS_H_ADDR));
+    CHECK(sensor.isGasHeatingSetupStable());
+    CHECK_EQUAL(BME680_OS_2X << 5 | BME680_OS_4X << 2, simulator.reg(BME680_CONF_T_P_MODE_ADDR) & ~BME680_MODE_MSK);
+}
+
+static void testSameAsSetters() {
+    BME680Simulator first(0x76 << 1), second(0x77 << 1);
+    BME680 configured(0x76 << 1, I2C_SDA, I2C_SCL), set(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(configured.begin<Config>());
+
+    CHECK(set.begin());
+    CHECK(set.setTemperatureOversampling(BME680_OS_2X));
+    CHECK(set.setPressureOversampling(BME680_OS_4X));
+    CHECK(set.setHumidityOversampling(BME680_OS_1X));
+    CHECK(set.setIIRFilterSize(BME680_FILTER_SIZE_7));
+    CHECK(set.setGasHeater(300, 100));
+
+    CHECK(configured.performReading());
+    CHECK(set.performReading());
+    CHECK_EQUAL(set.getProfileDuration(), configured.getProfileDuration());
+    CHECK_EQUAL(set.getRawTemperature(), configured.getRawTemperature());
+    CHECK_EQUAL(set.getRawGasResistance(), configured.getRawGasResistance());
+
+    for (uint8_t reg = BME680_RES_HEAT0_ADDR; reg <= BME680_CONF_ODR_FILT_ADDR; reg++)
+        CHECK_EQUAL(second.reg(reg), first.reg(reg));
+}
+
+static void testSetterOverrides() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin<Config>());
+    CHECK(sensor.setHumidityOversampling(BME680_OS_8X));
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(BME680_OS_8X, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK(sensor.getProfileDuration() > Config::image.profileDuration);
+}
+
+int main() {
+    RUN(testImage);
+    RUN(testApply);
+    RUN(testSameAsSetters);
+    RUN(testSetterOverrides);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,78 @@
+#include "test.h"
+
+#include <math.h>
+
+#include "mbed_bme680_derived.h"
+
+/*
+ * Derived metrics against the formulas of the documented error bounds.
+ */
+
+/* Magnus formula, deci Pascal */
+static double referenceSaturation(double temperature) {
+    return 6112 * exp(17.62 * temperature / (243.12 + temperature));
+}
+
+static double referenceDewPoint(double vapourPressure) {
+    double l = log(vapourPressure / 611.2);
+
+    return 243.12 * l / (17.62 - l);
+}
+
+/* International barometric formula, metres */
+static double referenceAltitude(double pressure) {
+    return 44330.0 * (1 - pow(pressure / BME680_SEA_LEVEL_PRESSURE, 1 / 5.255));
+}
+
+static void testVapourPressure() {
+    BME680DerivedMetrics metrics;
+
+    for (int16_t temperature = -4000; temperature <= 8500; temperature += 50) {
+        double reference = referenceSaturation(temperature / 100.0) / 2;
+
+        metrics.update(temperature, 100000, 50000);
+        CHECK_NEAR(reference, metrics.getVapourPressure(), reference * 0.008 + 1);
+    }
+}
+
+static void testDewPoint() {
+    BME680DerivedMetrics metrics;
+
+    /* At 100 %RH the dew point is the temperature */
+    for (int16_t temperature = -3900; temperature <= 8400; temperature += 50) {
+        metrics.update(temperature, 100000, 100000);
+        CHECK_NEAR(temperature, metrics.getDewPoint(), 10);
+    }
+
+    for (uint32_t humidity = 10000; humidity <= 90000; humidity += 10000) {
+        metrics.update(2500, 100000, humidity);
+        CHECK_NEAR(referenceDewPoint(metrics.getVapourPressure() / 10.0) * 100, metrics.getDewPoint(), 10);
+    }
+
+    metrics.update(-4000, 100000, 1000);
+    CHECK_EQUAL(-4000, metrics.getDewPoint());
+}
+
+static void testAltitude() {
+    BME680DerivedMetrics metrics;
+
+    CHECK_EQUAL(0, (metrics.update(2500, BME680_SEA_LEVEL_PRESSURE, 40000), metrics.getAltitude()));
+
+    for (uint32_t pressure = 30000; pressure <= 110000; pressure += 7) {
+        metrics.update(2500, pressure, 40000);
+        CHECK_NEAR(referenceAltitude(pressure), metrics.getAltitude() / 100.0, pressure >= 80000 ? 0.5 : 2.2);
+    }
+
+    /* The reference pressure moves the zero */
+    metrics.setSeaLevelPressure(95000);
+    metrics.update(2500, 95000, 40000);
+    CHECK_EQUAL(0, metrics.getAltitude());
+}
+
+int main() {
+    RUN(testVapourPressure);
+    RUN(testDewPoint);
+    RUN(testAltitude);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,416 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680.h"
+
+/*
+ * BME680 against the simulated sensor: bus traffic, conversion delays and error handling.
+ */
+
+static uint64_t elapsedSince(uint64_t start) {
+    return mbed_mock::nowUs() - start;
+}
+
+static void expectMeasurement(BME680 &sensor, BME680Simulator &simulator) {
+    BME680Compensation compensation;
+    int32_t tFine;
+
+    compensation.load(BME680Simulator::calibration());
+
+    const struct bme680_field_data &data = sensor.getFieldData();
+
+    CHECK_EQUAL(compensation.temperature(494000, &tFine), data.temperature);
+    CHECK_EQUAL(compensation.pressure(355000, tFine), data.pressure);
+    CHECK_EQUAL(compensation.humidity(20300, tFine), data.humidity);
+    CHECK_EQUAL(compensation.gasResistance(680, 7), data.gas_resistance);
+    CHECK_EQUAL(simulator.reg(BME680_FIELD0_ADDR + 1), data.meas_index);
+}
+
+static void testBegin() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK_EQUAL(-1, sensor.getSensorID());
+    CHECK(sensor.begin());
+    CHECK_EQUAL(BME680_CHIP_ID, sensor.getSensorID());
+
+    /* begin() only prepares the settings, they are written with the first reading */
+    CHECK_EQUAL(0, simulator.measurements());
+}
+
+static void testBeginWithoutSensor() {
+    BME680 sensor(0x76 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(!sensor.begin());
+}
+
+static void testReading() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(1, simulator.measurements());
+    expectMeasurement(sensor, simulator);
+
+    CHECK(sensor.isGasHeatingSetupStable());
+    CHECK_NEAR(sensor.getRawTemperature() * 0.01f, sensor.getTemperature(), 1e-4);
+    CHECK_NEAR(sensor.getRawGasResistance(), sensor.getGasResistance(), 0.5);
+
+    /* A heater that did not reach its temperature gives no gas resistance */
+    simulator.setHeaterStable(false);
+    CHECK(sensor.performReading());
+    CHECK(!sensor.isGasHeatingSetupStable());
+    CHECK_EQUAL(0, sensor.getGasResistance());
+}
+
+static void testConversionDelay() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.performReading());
+
+    /* The reading blocks until the conversion is done, the wait is rounded up to the heater duration */
+    uint32_t conversion = simulator.measurementTime();
+    uint64_t start = mbed_mock::nowUs();
+
+    CHECK(sensor.performReading());
+    CHECK(elapsedSince(start) >= conversion);
+    CHECK(elapsedSince(start) < (uint64_t) sensor.getProfileDuration() * 1000 + 10000);
+
+    /* Without the heater only the oversampling counts */
+    CHECK(sensor.setGasHeater(0, 0));
+    CHECK(sensor.setTemperatureOversampling(BME680_OS_1X));
+    CHECK(sensor.setPressureOversampling(BME680_OS_1X));
+    CHECK(sensor.setHumidityOversampling(BME680_OS_1X));
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(11, sensor.getProfileDuration());
+
+    start = mbed_mock::nowUs();
+    CHECK(sensor.performReading());
+    CHECK(elapsedSince(start) < 15000);
+}
+
+static void testSettingsWrittenOnce() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+
+    for (int i = 0; i < 3; i++)
+        CHECK(sensor.performReading());
+
+    CHECK_EQUAL(1, simulator.writes(BME680_CONF_OS_H_ADDR));
+    CHECK_EQUAL(1, simulator.writes(BME680_RES_HEAT0_ADDR));
+    CHECK_EQUAL(1, simulator.writes(BME680_GAS_WAIT0_ADDR));
+
+    /* A setter only writes its own group again */
+    CHECK(sensor.setHumidityOversampling(BME680_OS_4X));
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(2, simulator.writes(BME680_CONF_OS_H_ADDR));
+    CHECK_EQUAL(1, simulator.writes(BME680_RES_HEAT0_ADDR));
+    CHECK_EQUAL(BME680_OS_4X, simulator.reg(BME680_CONF_OS_H_ADDR));
+}
+
+static void testGasDecimation() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680BurstStats stats;
+
+    CHECK(sensor.begin());
+    CHECK(sensor.setGasDecimation(2));
+    CHECK(sensor.performReading());
+    CHECK(sensor.isGasHeatingSetupStable());
+    uint32_t gas = sensor.getRawGasResistance();
+
+    /* The reading in between holds the gas resistance without the gas status bits */
+    simulator.setAdc(494000, 355000, 20300, 600, 7);
+    CHECK(sensor.performReading());
+    CHECK(!(sensor.getFieldData().status & (BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK)));
+    CHECK_EQUAL(gas, sensor.getRawGasResistance());
+    CHECK_NEAR(gas, sensor.getGasResistance(), 0.5);
+
+    /* Only the readings with a gas phase count for the burst statistics */
+    CHECK(sensor.performBurst(4, &stats));
+    CHECK_EQUAL(4, stats.temperature.count());
+    CHECK_EQUAL(2, stats.gasResistance.count());
+}
+
+static void testBusTraffic() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    uint8_t raw[BME680_FIELD_LENGTH];
+
+    CHECK(sensor.begin());
+    CHECK(sensor.performReading());
+
+    /* The field data is one burst read: register address write, repeated start, 15 bytes */
+    mbed_mock::resetBusStats();
+    CHECK(sensor.readRawFieldData(raw));
+    CHECK_EQUAL(2, mbed_mock::busStats().transactions);
+    CHECK_EQUAL(1, mbed_mock::busStats().bytesWritten);
+    CHECK_EQUAL(BME680_FIELD_LENGTH, mbed_mock::busStats().bytesRead);
+
+    /* The direct trigger saves the mode polling of the Bosch API */
+    mbed_mock::resetBusStats();
+    CHECK(sensor.performReading());
+    uint32_t polled = mbed_mock::busStats().transactions;
+
+    sensor.setDirectMode(true);
+    mbed_mock::resetBusStats();
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(3, mbed_mock::busStats().transactions);
+    CHECK(mbed_mock::busStats().transactions < polled);
+    expectMeasurement(sensor, simulator);
+
+    /* The instrumentation counts the same traffic */
+    sensor.resetStats();
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(2, sensor.getStats().transactions);
+    CHECK_EQUAL(1, sensor.getStats().wait.count);
+    CHECK_EQUAL(1, sensor.getStats().read.count);
+}
+
+static void testRetry() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.performReading());
+    sensor.resetStats();
+
+    /* One NACK is absorbed by the transaction retry */
+    mbed_mock::failNext(1);
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(1, sensor.getStats().nacks);
+    CHECK_EQUAL(1, sensor.getStats().retries);
+    CHECK_EQUAL(0, sensor.getStats().errors);
+    expectMeasurement(sensor, simulator);
+}
+
+static void testSensorLost() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.performReading());
+
+    simulator.setPresent(false);
+    CHECK(!sensor.performReading());
+    CHECK(sensor.getStats().errors > 0);
+
+    simulator.setPresent(true);
+    CHECK(sensor.performReading());
+    expectMeasurement(sensor, simulator);
+}
+
+static void testPowerGlitch() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    CHECK(sensor.begin());
+    sensor.frequency(400000);
+    CHECK(sensor.performReading());
+
+    /* The glitch resets the sensor and fails the reading, the owned bus is rebuilt at its frequency */
+    simulator.setPresent(false);
+    simulator.powerCycle();
+    CHECK(!sensor.performReading());
+    CHECK_EQUAL(1, I2C::instances());
+    CHECK_EQUAL(400000, I2C::lastFrequency());
+
+    /* The settings lost with the reset are written with the next reading */
+    simulator.setPresent(true);
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(BME680_OS_2X, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK(simulator.reg(BME680_GAS_WAIT0_ADDR) != 0);
+    CHECK(simulator.reg(BME680_CONF_ODR_RUN_GAS_NBC_ADDR) & BME680_RUN_GAS_MSK);
+    expectMeasurement(sensor, simulator);
+}
+
+static void testSnapshot() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680Snapshot snapshot;
+
+    CHECK(!sensor.exportSnapshot(&snapshot));
+    CHECK(sensor.begin());
+    CHECK(sensor.setHumidityOversampling(BME680_OS_4X));
+    CHECK(sensor.setGasHeater(300, 80));
+    CHECK(sensor.performReading());
+    CHECK(sensor.exportSnapshot(&snapshot));
+
+    /* The warm boot only reads the chip ID, there is no soft reset and no calibration read */
+    BME680 warm(0x77 << 1, I2C_SDA, I2C_SCL);
+    uint32_t resets = simulator.writes(BME680_SOFT_RESET_ADDR);
+
+    simulator.powerCycle();
+    mbed_mock::resetBusStats();
+    CHECK(warm.begin(snapshot));
+    CHECK_EQUAL(1, mbed_mock::busStats().bytesRead);
+    CHECK_EQUAL(resets, simulator.writes(BME680_SOFT_RESET_ADDR));
+
+    /* The snapshot settings are written with the first reading */
+    CHECK(warm.performReading());
+    CHECK_EQUAL(BME680_OS_4X, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK_EQUAL(BME680Compensation::heaterDuration(80), simulator.reg(BME680_GAS_WAIT0_ADDR));
+    CHECK_EQUAL(sensor.getProfileDuration(), warm.getProfileDuration());
+    expectMeasurement(warm, simulator);
+}
+
+static void testSnapshotRejected() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL), other(0x76 << 1, I2C_SDA, I2C_SCL);
+    BME680Snapshot snapshot;
+
+    CHECK(sensor.begin());
+    CHECK(sensor.exportSnapshot(&snapshot));
+
+    /* Another address, a corrupted calibration or another version */
+    CHECK(!other.begin(snapshot));
+
+    BME680 warm(0x77 << 1, I2C_SDA, I2C_SCL);
+
+    snapshot.calib.par_t1++;
+    CHECK(!warm.begin(snapshot));
+    snapshot.calib.par_t1--;
+    snapshot.version++;
+    CHECK(!warm.begin(snapshot));
+    snapshot.version--;
+
+    /* No sensor on the bus */
+    simulator.setPresent(false);
+    CHECK(!warm.begin(snapshot));
+    simulator.setPresent(true);
+    CHECK(warm.begin(snapshot));
+}
+
+static void testHeaterProfile() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680Compensation compensation;
+    const uint16_t temps[] = {200, 300, 400}, times[] = {50, 100, 150};
+    uint32_t gasResistance;
+
+    compensation.load(BME680Simulator::calibration());
+
+    CHECK(sensor.begin());
+    CHECK(!sensor.setHeaterProfile(temps, times, 0));
+    CHECK(!sensor.setHeaterProfile(temps, times, BME680_HEATER_PROFILE_LEN + 1));
+    CHECK(sensor.setHeaterProfile(temps, times, 3));
+    CHECK(!sensor.getHeaterProfileResult(0, &gasResistance));
+
+    /* All set-points are programmed with the first reading, the readings cycle through the steps */
+    for (uint8_t i = 0; i < 4; i++) {
+        uint64_t start = mbed_mock::nowUs();
+
+        CHECK(sensor.performReading());
+        CHECK_EQUAL(i % 3, sensor.getHeaterProfileStep());
+        CHECK_EQUAL(i % 3, simulator.reg(BME680_CONF_ODR_RUN_GAS_NBC_ADDR) & BME680_NBCONV_MSK);
+        CHECK(elapsedSince(start) >= times[i % 3] * 1000U);
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK_EQUAL(compensation.heaterResistance(temps[i], 25), simulator.reg(BME680_RES_HEAT0_ADDR + i));
+        CHECK_EQUAL(BME680Compensation::heaterDuration(times[i]), simulator.reg(BME680_GAS_WAIT0_ADDR + i));
+        CHECK(sensor.getHeaterProfileResult(i, &gasResistance));
+        CHECK_EQUAL(compensation.gasResistance(680, 7), gasResistance);
+    }
+    CHECK(!sensor.getHeaterProfileResult(3, &gasResistance));
+    CHECK_EQUAL(1, simulator.writes(BME680_RES_HEAT0_ADDR));
+
+    /* A single heater set-point ends the sequence */
+    CHECK(sensor.setGasHeater(320, 150));
+    CHECK(sensor.performReading());
+    CHECK_EQUAL(0, sensor.getHeaterProfileStep());
+    CHECK(!sensor.getHeaterProfileResult(0, &gasResistance));
+}
+
+static void testNonBlocking() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680Reading latest;
+
+    CHECK(sensor.begin());
+    CHECK(!sensor.getLatest(&latest));
+    CHECK(!sensor.fetchResult());
+
+    uint16_t duration = sensor.startMeasurement();
+
+    CHECK_EQUAL(sensor.getProfileDuration(), duration);
+    CHECK(!sensor.isMeasurementReady());
+
+    ThisThread::sleep_for(std::chrono::milliseconds(duration));
+    CHECK(sensor.isMeasurementReady());
+    CHECK(sensor.fetchResult());
+    CHECK(!sensor.isMeasurementReady());
+    expectMeasurement(sensor, simulator);
+
+    CHECK(sensor.getLatest(&latest));
+    CHECK_EQUAL(sensor.getRawTemperature(), latest.temperature);
+    CHECK_EQUAL(sensor.getRawGasResistance(), latest.gasResistance);
+    CHECK_EQUAL((uint32_t) (mbed_mock::nowUs() / 1000), latest.timestamp);
+}
+
+static int completions;
+static bool completedWith;
+
+static void onDone(bool success) {
+    completions++;
+    completedWith = success;
+}
+
+static void testEventQueue() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    EventQueue queue;
+
+    CHECK(sensor.begin());
+    completions = 0;
+    CHECK(sensor.startMeasurement(queue, callback(onDone)));
+
+    CHECK_EQUAL(0, queue.dispatchDue());
+    ThisThread::sleep_for(std::chrono::milliseconds(sensor.getProfileDuration()));
+    CHECK_EQUAL(1, queue.dispatchDue());
+    CHECK_EQUAL(1, completions);
+    CHECK(completedWith);
+    expectMeasurement(sensor, simulator);
+}
+
+static void testSharedBus() {
+    BME680Simulator first(0x76 << 1), second(0x77 << 1);
+    I2C i2c(I2C_SDA, I2C_SCL);
+    BME680 a(0x76 << 1, i2c), b(0x77 << 1, i2c);
+
+    CHECK(a.begin());
+    CHECK(b.begin());
+
+    second.setAdc(520000, 355000, 20300, 680, 7);
+    CHECK(a.performReading());
+    CHECK(b.performReading());
+    CHECK(b.getRawTemperature() > a.getRawTemperature());
+    CHECK_EQUAL(1, first.measurements());
+    CHECK_EQUAL(1, second.measurements());
+}
+
+int main() {
+    RUN(testBegin);
+    RUN(testBeginWithoutSensor);
+    RUN(testReading);
+    RUN(testConversionDelay);
+    RUN(testSettingsWrittenOnce);
+    RUN(testGasDecimation);
+    RUN(testBusTraffic);
+    RUN(testRetry);
+    RUN(testSensorLost);
+    RUN(testPowerGlitch);
+    RUN(testSnapshot);
+    RUN(testSnapshotRejected);
+    RUN(testHeaterProfile);
+    RUN(testNonBlocking);
+    RUN(testEventQueue);
+    RUN(testSharedBus);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,143 @@
+#include "test.h"
+
+#include "mbed_bme680_filter.h"
+
+#define STABLE (BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK)
+
+static struct bme680_field_data sample(int16_t temperature, uint32_t gasResistance, uint8_t status = STABLE) {
+    struct bme680_field_data data = bme680_field_data();
+
+    data.status = status;
+    data.temperature = temperature;
+    data.pressure = 100000;
+    data.humidity = 40000;
+    data.gas_resistance = gasResistance;
+    return data;
+}
+
+static void testMedian() {
+    BME680MedianFilter<3> median;
+    const int32_t in[] = {10, 12, 500, 11, 13, -400, 12};
+    const int32_t expected[] = {10, 10, 12, 12, 13, 11, 12};
+    int32_t out;
+
+    /* Single sample spikes never reach the output */
+    for (size_t i = 0; i < sizeof(in) / sizeof(in[0]); i++) {
+        CHECK(median.update(in[i], &out));
+        CHECK_EQUAL(expected[i], out);
+    }
+
+    median.reset();
+    CHECK(median.update(7, &out));
+    CHECK_EQUAL(7, out);
+}
+
+static void testMedianDuplicates() {
+    BME680MedianFilter<5> median;
+    int32_t out = 0;
+
+    for (int i = 0; i < 20; i++)
+        median.update(i % 2 ? 3 : 3 + i, &out);
+
+    /* Window 3, 19, 3, 21, 3, the equal values are located in the sorted window */
+    CHECK_EQUAL(3, out);
+
+    median.update(30, &out);
+    median.update(30, &out);
+    CHECK_EQUAL(21, out);
+}
+
+static void testEMA() {
+    BME680EMAFilter<2> ema;
+    int32_t out;
+
+    /* The first value primes the state */
+    CHECK(ema.update(1000, &out));
+    CHECK_EQUAL(1000, out);
+
+    CHECK(ema.update(2000, &out));
+    CHECK_EQUAL(1250, out);
+
+    /* Steps below 2^Shift are kept in the fraction bits and converge */
+    for (int i = 0; i < 100; i++)
+        ema.update(2003, &out);
+
+    CHECK_EQUAL(2003, out);
+
+    /* Negative values round to nearest as well */
+    ema.reset();
+    ema.update(-1000, &out);
+    CHECK_EQUAL(-1000, out);
+    ema.update(-2000, &out);
+    CHECK_EQUAL(-1250, out);
+}
+
+static void testDecimator() {
+    BME680Decimator<4> decimator;
+    int32_t out = 0;
+
+    CHECK(!decimator.update(1, &out));
+    CHECK(!decimator.update(2, &out));
+    CHECK(!decimator.update(3, &out));
+    CHECK(decimator.update(6, &out));
+    CHECK_EQUAL(3, out);
+
+    /* The next window starts empty */
+    CHECK(!decimator.update(100, &out));
+    decimator.reset();
+    for (int i = 0; i < 3; i++)
+        CHECK(!decimator.update(8, &out));
+    CHECK(decimator.update(8, &out));
+    CHECK_EQUAL(8, out);
+}
+
+static void testChain() {
+    BME680FilterChain<BME680MedianFilter<3>, BME680Decimator<2>> chain;
+    BME680FilterChain<> empty;
+    int32_t out = 0;
+
+    CHECK(empty.update(42, &out));
+    CHECK_EQUAL(42, out);
+
+    /* Median 10, 10 -> decimated 10; median 12, 12 -> decimated 12 */
+    CHECK(!chain.update(10, &out));
+    CHECK(chain.update(1000, &out));
+    CHECK_EQUAL(10, out);
+    CHECK(!chain.update(12, &out));
+    CHECK(chain.update(12, &out));
+    CHECK_EQUAL(12, out);
+
+    chain.reset();
+    CHECK(!chain.update(5, &out));
+}
+
+static void testPipeline() {
+    BME680FilterPipeline<BME680Decimator<2>, BME680NoFilter, BME680NoFilter, BME680EMAFilter<1>> pipeline;
+
+    /* The temperature decimator holds back the output of every other reading */
+    CHECK(!pipeline.update(sample(2000, 40000)));
+    CHECK(pipeline.update(sample(2100, 60000)));
+    CHECK_EQUAL(2050, pipeline.getOutput().temperature);
+    CHECK_EQUAL(100000, pipeline.getOutput().pressure);
+    CHECK_EQUAL(40000, pipeline.getOutput().humidity);
+    CHECK_EQUAL(50000, pipeline.getOutput().gas_resistance);
+
+    /* Readings without a stable gas value keep the gas output, the status follows the input */
+    CHECK(!pipeline.update(sample(2000, 1, BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK)));
+    CHECK_EQUAL(50000, pipeline.getOutput().gas_resistance);
+    CHECK_EQUAL(BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK, pipeline.getOutput().status);
+
+    pipeline.reset();
+    CHECK_EQUAL(0, pipeline.getOutput().gas_resistance);
+}
+
+int main() {
+    RUN(testMedian);
+    RUN(testMedianDuplicates);
+    RUN(testEMA);
+    RUN(testDecimator);
+    RUN(testChain);
+    RUN(testPipeline);
+
+    return TEST_RESULT;
+}
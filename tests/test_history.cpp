@@ -0,0 +1,184 @@
+#include "test.h"
+
+#include "bme680.h"
+#include "mbed_bme680_history.h"
+
+#define STABLE (BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK)
+
+static BME680Record sample(uint32_t timestamp, int16_t temperature, uint32_t gasResistance = 50000,
+                           uint8_t status = STABLE) {
+    BME680Record record;
+
+    record.timestamp = timestamp;
+    record.status = status;
+    record.temperature = temperature;
+    record.pressure = 100000;
+    record.humidity = 40000;
+    record.gasResistance = gasResistance;
+    return record;
+}
+
+static void testValues() {
+    BME680Record record = sample(0, -1234, 123456);
+
+    record.pressure = 100001;
+    record.humidity = 41236;
+
+    BME680HistoryValues values = BME680HistoryValues::encode(record);
+
+    CHECK_EQUAL(-1234, values.getTemperature());
+    CHECK_EQUAL(100002, values.getPressure());
+    CHECK_EQUAL(41240, values.getHumidity());
+    CHECK_NEAR(123456, values.getGasResistance(), 123456 / 4096.0);
+
+    /* Without a stable gas reading the gas value is missing */
+    record.status = BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK;
+    CHECK_EQUAL(0, BME680HistoryValues::encode(record).gas);
+
+    /* Saturation */
+    record.pressure = 200000;
+    CHECK_EQUAL(UINT16_MAX, BME680HistoryValues::encode(record).pressure);
+}
+
+static void testGasCode() {
+    uint16_t previous = 0;
+
+    CHECK_EQUAL(1, BME680HistoryValues::encodeGas(0));
+    CHECK_EQUAL(0xfff, BME680HistoryValues::encodeGas(0xfff));
+    CHECK_EQUAL(0xffff, BME680HistoryValues::encodeGas(UINT32_MAX));
+
+    /* Codes keep the order of the resistances, bucket min and max rely on it.
+     * Each dropped bit is rounded, the error stays below one mantissa step. */
+    for (uint32_t ohm = 1; ohm < 130000000; ohm = ohm * 3 / 2 + 1) {
+        uint16_t code = BME680HistoryValues::encodeGas(ohm);
+        BME680HistoryValues values;
+
+        CHECK(code >= previous);
+        values.gas = code;
+        CHECK_NEAR(ohm, values.getGasResistance(), ohm / 2048.0 + 1);
+        previous = code;
+    }
+}
+
+static void testAccumulator() {
+    BME680HistoryAccumulator accumulator;
+
+    CHECK(accumulator.empty());
+
+    accumulator.reset(60000);
+    accumulator.add(BME680HistoryValues::encode(sample(60000, 2000, 40000)));
+    accumulator.add(BME680HistoryValues::encode(sample(61000, 2100, 60000)));
+    accumulator.add(BME680HistoryValues::encode(sample(62000, 2300, 0, BME680_NEW_DATA_MSK)));
+
+    BME680HistoryBucket bucket = accumulator.bucket();
+
+    CHECK_EQUAL(60000, bucket.start);
+    CHECK_EQUAL(3, bucket.count);
+    CHECK_EQUAL(2, bucket.gasCount);
+    CHECK_EQUAL(2000, bucket.min.temperature);
+    CHECK_EQUAL(2133, bucket.mean.temperature);
+    CHECK_EQUAL(2300, bucket.max.temperature);
+    CHECK_NEAR(40000, bucket.min.getGasResistance(), 16);
+    CHECK_NEAR(50000, bucket.mean.getGasResistance(), 16);
+    CHECK_NEAR(60000, bucket.max.getGasResistance(), 16);
+}
+
+static void testRing() {
+    BME680HistoryRing<BME680HistorySample, 4> ring;
+    BME680HistorySample item, out[4];
+
+    CHECK_EQUAL(0, ring.query(0, 100, out, 4));
+
+    for (uint32_t i = 0; i < 6; i++) {
+        item.timestamp = i * 10;
+        ring.push(item);
+    }
+
+    /* The two oldest items were overwritten */
+    CHECK_EQUAL(4, ring.size());
+    CHECK_EQUAL(20, ring.at(0).timestamp);
+    CHECK_EQUAL(50, ring.at(3).timestamp);
+
+    CHECK_EQUAL(2, ring.query(25, 50, out, 4));
+    CHECK_EQUAL(30, out[0].timestamp);
+    CHECK_EQUAL(40, out[1].timestamp);
+
+    CHECK_EQUAL(1, ring.query(20, 50, out, 1));
+    CHECK_EQUAL(20, out[0].timestamp);
+
+    /* Bounds outside the stored items */
+    CHECK_EQUAL(4, ring.query(0, UINT32_MAX, out, 4));
+    CHECK_EQUAL(20, out[0].timestamp);
+    CHECK_EQUAL(50, out[3].timestamp);
+    CHECK_EQUAL(2, ring.query(40, 1000, out, 4));
+    CHECK_EQUAL(0, ring.query(0, 20, out, 4));
+    CHECK_EQUAL(0, ring.query(60, UINT32_MAX, out, 4));
+    CHECK_EQUAL(0, ring.query(40, 30, out, 4));
+}
+
+static void testTiers() {
+    BME680History<100, 60, 6> history;
+    BME680HistorySample samples[100];
+    BME680HistoryBucket buckets[60];
+
+    CHECK(!history.getCurrentMinute(&buckets[0]));
+
+    /* 25 minutes at 10 s, the temperature follows the minute */
+    for (uint32_t t = 0; t < 25 * 60000; t += 10000)
+        history.add(sample(t, (int16_t) (2000 + t / 60000 * 10)));
+
+    CHECK_EQUAL(24, history.getMinuteBuckets(0, 25 * 60000, buckets, 60));
+    CHECK_EQUAL(0, buckets[0].start);
+    CHECK_EQUAL(6, buckets[0].count);
+    CHECK_EQUAL(2000, buckets[0].mean.temperature);
+    CHECK_EQUAL(23 * 60000, buckets[23].start);
+    CHECK_EQUAL(2230, buckets[23].mean.temperature);
+
+    CHECK_EQUAL(2, history.getTenMinuteBuckets(0, 25 * 60000, buckets, 6));
+    CHECK_EQUAL(600000, buckets[1].start);
+    CHECK_EQUAL(60, buckets[1].count);
+    CHECK_EQUAL(2100, buckets[1].min.temperature);
+    CHECK_EQUAL(2190, buckets[1].max.temperature);
+
+    CHECK(history.getCurrentMinute(&buckets[0]));
+    CHECK_EQUAL(24 * 60000, buckets[0].start);
+    CHECK_EQUAL(6, buckets[0].count);
+
+    /* Only the last 100 raw samples are kept */
+    CHECK_EQUAL(100, history.getSamples(0, 25 * 60000, samples, 100));
+    CHECK_EQUAL(50 * 10000, samples[0].timestamp);
+    CHECK_EQUAL(149 * 10000, samples[99].timestamp);
+
+    CHECK_EQUAL(100, history.getSamples(0, UINT32_MAX, samples, 100));
+    CHECK_EQUAL(6, history.getSamples(60000 * 20, 60000 * 21, samples, 100));
+    CHECK_EQUAL(2200, samples[0].values.getTemperature());
+}
+
+static void testTimestampWrap() {
+    BME680History<16, 4, 2> history;
+    BME680HistorySample samples[16];
+    uint32_t start = UINT32_MAX - 35000;
+
+    for (uint32_t i = 0; i < 8; i++)
+        history.add(sample(start + i * 10000, (int16_t) i));
+
+    /* The range crosses the wrap of the millisecond time */
+    CHECK_EQUAL(8, history.getSamples(start, start + 80000, samples, 16));
+    CHECK_EQUAL(0, samples[0].values.getTemperature());
+    CHECK_EQUAL(7, samples[7].values.getTemperature());
+    CHECK_EQUAL(4, history.getSamples(start - 1000, UINT32_MAX, samples, 16));
+    CHECK_EQUAL(3, samples[3].values.getTemperature());
+    CHECK_EQUAL(4, history.getSamples(0, 40000, samples, 16));
+    CHECK_EQUAL(4, samples[0].values.getTemperature());
+}
+
+int main() {
+    RUN(testValues);
+    RUN(testGasCode);
+    RUN(testAccumulator);
+    RUN(testRing);
+    RUN(testTiers);
+    RUN(testTimestampWrap);
+
+    return TEST_RESULT;
+}
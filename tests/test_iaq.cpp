@@ -0,0 +1,138 @@
+#include "test.h"
+
+#include "mbed_bme680_iaq.h"
+
+#define STABLE (BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK | BME680_HEAT_STAB_MSK)
+
+static struct bme680_field_data sample(uint32_t gasResistance, uint32_t humidity = 40000, uint8_t status = STABLE) {
+    struct bme680_field_data data = bme680_field_data();
+
+    data.status = status;
+    data.temperature = 2500;
+    data.pressure = 100000;
+    data.humidity = humidity;
+    data.gas_resistance = gasResistance;
+    return data;
+}
+
+static void testBurnIn() {
+    BME680IAQ iaq;
+
+    iaq.setBurnIn(4);
+    CHECK(!iaq.isCalibrated());
+
+    /* The baseline is the plain average while burning in */
+    CHECK(iaq.update(sample(40000)));
+    CHECK(iaq.update(sample(60000)));
+    CHECK(iaq.update(sample(50000)));
+    CHECK(!iaq.isCalibrated());
+    CHECK(iaq.update(sample(50000)));
+    CHECK(iaq.isCalibrated());
+    CHECK_NEAR(50000, iaq.getBaseline(), 1);
+}
+
+static void testUnusableSamples() {
+    BME680IAQ iaq;
+
+    CHECK(!iaq.update(sample(50000, 40000, BME680_NEW_DATA_MSK)));
+    CHECK(!iaq.update(sample(50000, 40000, BME680_NEW_DATA_MSK | BME680_GASM_VALID_MSK)));
+    CHECK(!iaq.update(sample(0)));
+    CHECK_EQUAL(0, iaq.getBaseline());
+}
+
+static void testBaselineAsymmetry() {
+    BME680IAQ iaq;
+
+    iaq.setBurnIn(1);
+    iaq.setBaselineSpeed(2);
+    iaq.update(sample(100000));
+
+    /* Rising resistance moves the baseline by a quarter, falling resistance 16 times slower */
+    iaq.update(sample(140000));
+    CHECK_NEAR(110000, iaq.getBaseline(), 1);
+
+    iaq.update(sample(46000));
+    CHECK_NEAR(109000, iaq.getBaseline(), 1);
+}
+
+static void testIndex() {
+    BME680IAQ iaq;
+
+    iaq.setBurnIn(1);
+    iaq.setHumidityReference(40000, 25);
+    iaq.update(sample(50000));
+
+    /* Clean air at the humidity reference is the best index */
+    CHECK_EQUAL(0, iaq.getIAQ());
+
+    /* Half the baseline resistance costs half the gas share: 37.5 % of 500 */
+    iaq.update(sample(25000));
+    CHECK_NEAR(187, iaq.getIAQ(), 2);
+
+    /* Humidity away from the reference costs its share */
+    iaq.reset();
+    iaq.update(sample(50000, 20000));
+    CHECK_NEAR(62, iaq.getIAQ(), 1);
+
+    iaq.setHumidityReference(40000, 0);
+    iaq.update(sample(50000, 0));
+    CHECK_EQUAL(0, iaq.getIAQ());
+}
+
+static void testHumidityCompensation() {
+    BME680IAQ iaq;
+
+    iaq.setBurnIn(1);
+    iaq.update(sample(50000));
+
+    /* 4 % per %RH: the resistance drop of 10 %RH more humidity is not taken for pollution */
+    CHECK(iaq.update(sample(35715, 50000)));
+    CHECK_NEAR(50000, iaq.getBaseline(), 1);
+    CHECK_NEAR(20, iaq.getIAQ(), 1);
+
+    iaq.setHumidityCompensation(0);
+    CHECK(iaq.update(sample(35715, 50000)));
+    CHECK_NEAR(128, iaq.getIAQ(), 1);
+
+    /* The correction factor is limited, dry air does not zero the resistance */
+    iaq.reset();
+    iaq.setHumidityCompensation(40);
+    iaq.update(sample(80000, 0));
+    CHECK_EQUAL(20000, iaq.getBaseline());
+}
+
+static void testState() {
+    BME680IAQ iaq, restored;
+    BME680IAQState state;
+
+    iaq.setBurnIn(2);
+    iaq.update(sample(40000));
+    iaq.update(sample(60000));
+    iaq.exportState(&state);
+
+    CHECK(restored.importState(state));
+    restored.setBurnIn(2);
+    CHECK(restored.isCalibrated());
+    CHECK_EQUAL(iaq.getBaseline(), restored.getBaseline());
+    CHECK_EQUAL(iaq.getDeviation(), restored.getDeviation());
+
+    /* Another version or a corrupted state are rejected */
+    state.version++;
+    CHECK(!restored.importState(state));
+    state.version--;
+    state.baseline++;
+    CHECK(!restored.importState(state));
+    state.baseline--;
+    CHECK(restored.importState(state));
+}
+
+int main() {
+    RUN(testBurnIn);
+    RUN(testUnusableSamples);
+    RUN(testBaselineAsymmetry);
+    RUN(testIndex);
+    RUN(testHumidityCompensation);
+    RUN(testState);
+
+    return TEST_RESULT;
+}
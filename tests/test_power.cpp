@@ -0,0 +1,150 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_power.h"
+#include "mbed_bme680_thresholds.h"
+
+/*
+ * Adaptive fidelity levels against the simulated sensor.
+ */
+
+static void testLevels() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680PowerManager manager(sensor);
+
+    CHECK(sensor.begin());
+    manager.setStableSamples(3);
+
+    /* High fidelity until the readings are stable */
+    for (int i = 0; i < 3; i++) {
+        CHECK(!manager.isLowPower());
+        CHECK(manager.performReading());
+        CHECK_EQUAL(BME680_OS_2X, simulator.reg(BME680_CONF_OS_H_ADDR));
+        CHECK(sensor.isGasHeatingSetupStable());
+    }
+
+    /* The first reading is the reference, three more are within the thresholds */
+    CHECK(manager.performReading());
+    CHECK(manager.isLowPower());
+
+    CHECK(manager.performReading());
+    CHECK_EQUAL(BME680_OS_1X, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK_EQUAL(BME680_OS_1X << 5 | BME680_OS_1X << 2, simulator.reg(BME680_CONF_T_P_MODE_ADDR) & ~BME680_MODE_MSK);
+    CHECK(!(sensor.getFieldData().status & BME680_GASM_VALID_MSK));
+
+    /* A temperature step is back to high fidelity */
+    simulator.setAdc(520000, 355000, 20300, 680, 7);
+    CHECK(manager.performReading());
+    CHECK(!manager.isLowPower());
+    CHECK(manager.performReading());
+    CHECK_EQUAL(BME680_OS_2X, simulator.reg(BME680_CONF_OS_H_ADDR));
+    CHECK(sensor.isGasHeatingSetupStable());
+}
+
+static void testDrift() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680PowerManager manager(sensor);
+    uint32_t adc = 494000;
+
+    CHECK(sensor.begin());
+    manager.setStableSamples(2);
+
+    for (int i = 0; i < 3; i++)
+        CHECK(manager.performReading());
+    CHECK(manager.isLowPower());
+
+    int16_t reference = sensor.getRawTemperature(), previous = reference;
+    bool switched = false;
+
+    /* Each step stays within the threshold, the drift since the level switch does not */
+    for (int i = 0; i < 50 && !switched; i++) {
+        adc += 100;
+        simulator.setAdc(adc, 355000, 20300, 680, 7);
+        CHECK(manager.performReading());
+
+        int16_t temperature = sensor.getRawTemperature();
+
+        CHECK(temperature - previous <= BME680_DEFAULT_TEMP_THRESHOLD);
+        previous = temperature;
+        switched = !manager.isLowPower();
+    }
+
+    CHECK(switched);
+    CHECK(previous - reference > BME680_DEFAULT_TEMP_THRESHOLD);
+    CHECK(previous - reference <= 2 * BME680_DEFAULT_TEMP_THRESHOLD);
+}
+
+static void testDuration() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680PowerManager manager(sensor);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.setGasHeater(320, 150));
+    manager.setStableSamples(1);
+
+    /* The duration comes from the level table, the sensor settings are left alone */
+    uint16_t high = manager.getProfileDuration();
+
+    CHECK_EQUAL(sensor.getProfileDuration(), high);
+    CHECK(manager.performReading());
+    CHECK_EQUAL(high, sensor.getProfileDuration());
+
+    CHECK(manager.performReading());
+    CHECK(manager.isLowPower());
+
+    /* The low level runs neither the heater nor the large oversampling */
+    uint16_t low = manager.getProfileDuration();
+    uint32_t writes = simulator.writes();
+
+    CHECK_EQUAL(high, sensor.getProfileDuration());
+    CHECK_EQUAL(writes, simulator.writes());
+    CHECK(low < high);
+    CHECK(high - low > 150);
+
+    uint64_t start = mbed_mock::nowUs();
+
+    CHECK(manager.performReading());
+    CHECK(mbed_mock::nowUs() - start < (low + 5) * 1000U);
+    CHECK_EQUAL(low, sensor.getProfileDuration());
+}
+
+static void testLatencyBudget() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680PowerManager manager(sensor);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.setGasHeater(320, 150));
+
+    /* The heater phase does not fit, the high level drops it */
+    manager.setLatencyBudget(100);
+    CHECK(manager.getProfileDuration() <= 100);
+    CHECK(manager.performReading());
+    CHECK(!(sensor.getFieldData().status & BME680_GASM_VALID_MSK));
+    CHECK(manager.getProfileDuration() <= 100);
+
+    manager.setLatencyBudget(0);
+    CHECK(manager.performReading());
+    CHECK(sensor.isGasHeatingSetupStable());
+}
+
+static void testLevelsWithoutSensor() {
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680PowerManager manager(sensor);
+
+    CHECK(!manager.performReading());
+    CHECK(!manager.isLowPower());
+}
+
+int main() {
+    RUN(testLevels);
+    RUN(testDrift);
+    RUN(testDuration);
+    RUN(testLatencyBudget);
+    RUN(testLevelsWithoutSensor);
+
+    return TEST_RESULT;
+}
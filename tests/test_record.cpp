@@ -0,0 +1,133 @@
+#include "test.h"
+
+#include <string.h>
+
+#include "mbed_bme680_record.h"
+
+static BME680Record record(uint32_t timestamp, int16_t temperature, uint32_t pressure, uint32_t humidity,
+                           uint32_t gasResistance, uint8_t status = 0xb0) {
+    BME680Record record;
+
+    record.timestamp = timestamp;
+    record.status = status;
+    record.temperature = temperature;
+    record.pressure = pressure;
+    record.humidity = humidity;
+    record.gasResistance = gasResistance;
+    return record;
+}
+
+static bool same(const BME680Record &a, const BME680Record &b) {
+    return a.timestamp == b.timestamp && a.status == b.status && a.temperature == b.temperature
+           && a.pressure == b.pressure && a.humidity == b.humidity && a.gasResistance == b.gasResistance;
+}
+
+static void testRoundTrip() {
+    uint8_t buffer[256];
+    BME680RecordEncoder encoder(buffer, sizeof(buffer));
+    BME680Record records[] = {
+            record(0, 2512, 100123, 41234, 50321),
+            record(1000, 2513, 100121, 41200, 50290),
+            record(2000, -4000, 30000, 0, 0, 0x80),
+            record(3000, 8500, 110000, 100000, UINT32_MAX),
+            record(4294967000UL, INT16_MIN, UINT32_MAX, 7, 1),
+            record(704, INT16_MAX, 0, 100000, 12345),  // timestamp wraps around
+    };
+    const size_t count = sizeof(records) / sizeof(records[0]);
+
+    for (size_t i = 0; i < count; i++)
+        CHECK(encoder.append(records[i]) > 0);
+
+    BME680RecordDecoder decoder(encoder.data(), encoder.length());
+    BME680Record decoded;
+
+    for (size_t i = 0; i < count; i++) {
+        CHECK(decoder.next(decoded));
+        CHECK(same(records[i], decoded));
+    }
+
+    CHECK(!decoder.next(decoded));
+    CHECK(!decoder.isCorrupt());
+}
+
+static void testSteadyStreamSize() {
+    uint8_t buffer[1024];
+    BME680RecordEncoder encoder(buffer, sizeof(buffer));
+
+    encoder.append(record(0, 2500, 100000, 40000, 50000));
+    size_t start = encoder.length();
+
+    /* 1 Hz with small drifts, as documented 8 to 10 bytes per record */
+    for (uint32_t i = 1; i <= 50; i++)
+        encoder.append(record(i * 1000, (int16_t) (2500 + (i % 3)), 100000 - (i % 5), 40000 + (i % 40),
+                              50000 + (i % 100) * 9));
+
+    size_t perRecord = (encoder.length() - start) / 50;
+
+    CHECK(perRecord >= 7);
+    CHECK(perRecord <= 10);
+}
+
+static void testWorstCaseSize() {
+    uint8_t buffer[2 * BME680_RECORD_MAX_SIZE];
+    BME680RecordEncoder encoder(buffer, sizeof(buffer));
+
+    CHECK(encoder.append(record(UINT32_MAX, INT16_MIN, UINT32_MAX, UINT32_MAX, UINT32_MAX)) <= BME680_RECORD_MAX_SIZE);
+    CHECK(encoder.append(record(UINT32_MAX - 1, INT16_MAX, 0, 0, 0)) <= BME680_RECORD_MAX_SIZE);
+}
+
+static void testBufferFull() {
+    uint8_t buffer[12];
+    BME680RecordEncoder encoder(buffer, sizeof(buffer));
+
+    CHECK(encoder.append(record(0, 1, 2, 3, 4)) > 0);
+    size_t length = encoder.length();
+
+    /* A record that does not fit is not written and does not change the delta base */
+    CHECK_EQUAL(0, encoder.append(record(1000, 30000, 4000000, 4000000, 4000000)));
+    CHECK_EQUAL(length, encoder.length());
+
+    BME680RecordDecoder decoder(encoder.data(), encoder.length());
+    BME680Record decoded;
+
+    CHECK(decoder.next(decoded));
+    CHECK(same(record(0, 1, 2, 3, 4), decoded));
+    CHECK(!decoder.next(decoded));
+
+    encoder.reset();
+    CHECK_EQUAL(0, encoder.length());
+}
+
+static void testTruncated() {
+    uint8_t buffer[64];
+    BME680RecordEncoder encoder(buffer, sizeof(buffer));
+    BME680Record decoded;
+
+    encoder.append(record(0, 2500, 100000, 40000, 50000));
+    encoder.append(record(1000, 2501, 100002, 40010, 50100));
+
+    BME680RecordDecoder decoder(encoder.data(), encoder.length() - 1);
+
+    CHECK(decoder.next(decoded));
+    CHECK(!decoder.next(decoded));
+    CHECK(decoder.isCorrupt());
+    CHECK(!decoder.next(decoded));
+
+    /* A varint that never ends is malformed */
+    uint8_t malformed[16];
+    memset(malformed, 0xff, sizeof(malformed));
+    BME680RecordDecoder endless(malformed, sizeof(malformed));
+
+    CHECK(!endless.next(decoded));
+    CHECK(endless.isCorrupt());
+}
+
+int main() {
+    RUN(testRoundTrip);
+    RUN(testSteadyStreamSize);
+    RUN(testWorstCaseSize);
+    RUN(testBufferFull);
+    RUN(testTruncated);
+
+    return TEST_RESULT;
+}
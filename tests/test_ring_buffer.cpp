@@ -0,0 +1,80 @@
+#include "test.h"
+
+#include "mbed_bme680_ring_buffer.h"
+
+static void testEmpty() {
+    BME680RingBuffer<int, 4> buffer;
+    int item = 42;
+
+    CHECK(buffer.empty());
+    CHECK_EQUAL(0, buffer.size());
+    CHECK_EQUAL(4, buffer.capacity());
+    CHECK(!buffer.pop(item));
+    CHECK_EQUAL(42, item);
+}
+
+static void testOrder() {
+    BME680RingBuffer<int, 4> buffer;
+    int item;
+
+    CHECK(buffer.push(1));
+    CHECK(buffer.push(2));
+    CHECK(buffer.push(3));
+    CHECK_EQUAL(3, buffer.size());
+
+    CHECK(buffer.pop(item));
+    CHECK_EQUAL(1, item);
+    CHECK(buffer.pop(item));
+    CHECK_EQUAL(2, item);
+    CHECK(buffer.pop(item));
+    CHECK_EQUAL(3, item);
+    CHECK(buffer.empty());
+}
+
+static void testFull() {
+    BME680RingBuffer<int, 4> buffer;
+    int item;
+
+    for (int i = 0; i < 4; i++)
+        CHECK(buffer.push(i));
+
+    /* A full buffer keeps its items and rejects the new one */
+    CHECK(!buffer.push(99));
+    CHECK_EQUAL(4, buffer.size());
+
+    CHECK(buffer.pop(item));
+    CHECK_EQUAL(0, item);
+    CHECK(buffer.push(4));
+
+    for (int i = 1; i <= 4; i++) {
+        CHECK(buffer.pop(item));
+        CHECK_EQUAL(i, item);
+    }
+}
+
+static void testWrapAround() {
+    BME680RingBuffer<uint32_t, 8> buffer;
+    uint32_t next = 0, expected = 0, item;
+
+    /* Interleaved pushes and pops run the indices around the storage many times */
+    for (int round = 0; round < 1000; round++) {
+        for (int i = 0; i < 5; i++)
+            CHECK(buffer.push(next++));
+
+        for (int i = 0; i < 5; i++) {
+            CHECK(buffer.pop(item));
+            CHECK_EQUAL(expected++, item);
+        }
+    }
+
+    CHECK(buffer.empty());
+}
+
+int main() {
+    RUN(testEmpty);
+    RUN(testOrder);
+    RUN(testFull);
+    RUN(testWrapAround);
+
+    return TEST_RESULT;
+}
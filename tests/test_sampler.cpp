@@ -0,0 +1,156 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_sampler.h"
+
+/*
+ * Continuous sampling against the simulated sensor, timed by mbed_mock::runFor.
+ */
+
+static uint32_t nowMs() {
+    return (uint32_t) (mbed_mock::nowUs() / 1000);
+}
+
+static void testPeriodic() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    EventQueue queue;
+    BME680Sampler sampler(sensor, queue);
+    BME680Sample sample;
+
+    CHECK(sensor.begin());
+    CHECK(!sampler.isRunning());
+    CHECK(sampler.start(std::chrono::milliseconds(500)));
+    CHECK(sampler.isRunning());
+    CHECK(!sampler.start(std::chrono::milliseconds(500)));
+    CHECK(!sampler.startLowPower(std::chrono::milliseconds(500)));
+
+    /* Four triggers, each sample stamped with its trigger time */
+    uint32_t start = nowMs();
+
+    CHECK(!sampler.pop(sample));
+    mbed_mock::runFor(2300000);
+
+    for (uint32_t i = 1; i <= 4; i++) {
+        CHECK(sampler.pop(sample));
+        CHECK_NEAR(start + i * 500, sample.timestamp, 1);
+        CHECK(sample.data.status & BME680_NEW_DATA_MSK);
+        CHECK_EQUAL(sensor.getRawTemperature(), sample.data.temperature);
+    }
+    CHECK(!sampler.pop(sample));
+    CHECK_EQUAL(4, simulator.measurements());
+
+    /* A stopped sampler triggers nothing, the queue is empty */
+    sampler.stop();
+    CHECK(!sampler.isRunning());
+    mbed_mock::runFor(2000000);
+    CHECK_EQUAL(4, simulator.measurements());
+    CHECK_EQUAL(0, queue.pending());
+    CHECK_EQUAL(0, sampler.getOverruns());
+    CHECK_EQUAL(0, sampler.getErrors());
+}
+
+static void testOverruns() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    EventQueue queue;
+    BME680Sampler sampler(sensor, queue);
+    BME680Sample sample;
+
+    CHECK(sensor.begin());
+
+    /* A trigger while the previous measurement is running is dropped */
+    uint32_t period = sensor.getProfileDuration() * 2 / 3;
+
+    CHECK(sampler.start(std::chrono::milliseconds(period)));
+    mbed_mock::runFor((10 * period + period / 2) * 1000U);
+    sampler.stop();
+    mbed_mock::runFor(1000000);
+
+    CHECK_EQUAL(5, simulator.measurements());
+    CHECK_EQUAL(5, sampler.getOverruns());
+
+    while (sampler.pop(sample));
+
+    /* A full buffer drops the new samples */
+    CHECK(sampler.start(std::chrono::milliseconds(500)));
+    mbed_mock::runFor((BME680_SAMPLER_BUFFER_SIZE + 3) * 500000U + 400000);
+    sampler.stop();
+
+    uint32_t popped = 0;
+
+    while (sampler.pop(sample))
+        popped++;
+
+    CHECK_EQUAL(BME680_SAMPLER_BUFFER_SIZE, popped);
+    CHECK_EQUAL(5 + 3, sampler.getOverruns());
+}
+
+static void testErrors() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    EventQueue queue;
+    BME680Sampler sampler(sensor, queue);
+    BME680Sample sample;
+
+    CHECK(sensor.begin());
+    CHECK(sampler.start(std::chrono::milliseconds(500)));
+
+    /* Failed triggers are counted, sampling goes on once the sensor is back */
+    simulator.setPresent(false);
+    mbed_mock::runFor(1100000);
+    CHECK_EQUAL(2, sampler.getErrors());
+    CHECK(!sampler.pop(sample));
+
+    simulator.setPresent(true);
+    mbed_mock::runFor(1200000);
+    CHECK(sampler.pop(sample));
+    CHECK(sampler.pop(sample));
+    CHECK_EQUAL(2, sampler.getErrors());
+    sampler.stop();
+}
+
+static void testLowPower() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    EventQueue queue;
+    BME680Sampler sampler(sensor, queue);
+    BME680Sample sample;
+
+    CHECK(sensor.begin());
+    CHECK(sampler.startLowPower(std::chrono::milliseconds(500)));
+    CHECK(sampler.isRunning());
+    CHECK(!sampler.startLowPower(std::chrono::milliseconds(500)));
+    CHECK(!sampler.start(std::chrono::milliseconds(500)));
+
+    /* The ticker posts the triggers, the timeout the reads: no queue timers in between */
+    uint32_t start = nowMs();
+
+    mbed_mock::runFor(510000);
+    CHECK_EQUAL(1, simulator.measurements());
+    CHECK_EQUAL(0, queue.pending());
+
+    mbed_mock::runFor(1800000);
+
+    for (uint32_t i = 1; i <= 4; i++) {
+        CHECK(sampler.pop(sample));
+        CHECK_NEAR(start + i * 500, sample.timestamp, 1);
+        CHECK(sample.data.status & BME680_NEW_DATA_MSK);
+    }
+    CHECK(!sampler.pop(sample));
+
+    sampler.stop();
+    CHECK(!sampler.isRunning());
+    mbed_mock::runFor(2000000);
+    CHECK_EQUAL(4, simulator.measurements());
+    CHECK_EQUAL(0, sampler.getErrors());
+}
+
+int main() {
+    RUN(testPeriodic);
+    RUN(testOverruns);
+    RUN(testErrors);
+    RUN(testLowPower);
+
+    return TEST_RESULT;
+}
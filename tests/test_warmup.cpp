@@ -0,0 +1,128 @@
+#include "test.h"
+
+#include "bme680_simulator.h"
+#include "mbed_bme680_warmup.h"
+
+/*
+ * Gas heater warm-up against the simulated sensor.
+ */
+
+static void testSettle() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680GasWarmup warmup(sensor, 320, 150);
+
+    CHECK(sensor.begin());
+
+    /* Shortened heating time until three consecutive readings were stable */
+    for (int i = 0; i < 3; i++) {
+        CHECK(!warmup.isSettled());
+        CHECK(warmup.performReading());
+        CHECK_EQUAL(BME680Compensation::heaterDuration(30), simulator.reg(BME680_GAS_WAIT0_ADDR));
+    }
+
+    CHECK(warmup.isSettled());
+    CHECK_EQUAL(0, warmup.getTimeToStable());
+
+    CHECK(warmup.performReading());
+    CHECK_EQUAL(BME680Compensation::heaterDuration(150), simulator.reg(BME680_GAS_WAIT0_ADDR));
+    CHECK_EQUAL(4, simulator.measurements());
+}
+
+static void testRetries() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680GasWarmup warmup(sensor, 320, 150);
+
+    CHECK(sensor.begin());
+
+    /* An unstable reading is retried right away while warming up */
+    simulator.setHeaterStable(false);
+    CHECK(warmup.performReading());
+    CHECK_EQUAL(3, simulator.measurements());
+    CHECK(!sensor.isGasHeatingSetupStable());
+
+    warmup.setWarmup(20, 2, 0);
+    CHECK(warmup.performReading());
+    CHECK_EQUAL(4, simulator.measurements());
+    CHECK_EQUAL(BME680Compensation::heaterDuration(20), simulator.reg(BME680_GAS_WAIT0_ADDR));
+
+    /* A settled heater that gets unstable warms up again, without retries */
+    simulator.setHeaterStable(true);
+    CHECK(warmup.performReading());
+    CHECK(warmup.performReading());
+    CHECK(warmup.isSettled());
+
+    simulator.setHeaterStable(false);
+    warmup.setWarmup(20, 2, 2);
+    uint32_t measurements = simulator.measurements();
+
+    CHECK(warmup.performReading());
+    CHECK_EQUAL(measurements + 1, simulator.measurements());
+    CHECK(!warmup.isSettled());
+}
+
+static void testGasDecimation() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680GasWarmup warmup(sensor, 320, 150);
+
+    CHECK(sensor.begin());
+    CHECK(sensor.setGasDecimation(2));
+
+    /* The readings in between have no gas phase, they are neither retried nor reset the stable count */
+    for (uint32_t i = 1; i <= 5; i++) {
+        CHECK(!warmup.isSettled());
+        CHECK(warmup.performReading());
+        CHECK_EQUAL(i, simulator.measurements());
+        CHECK_EQUAL(i % 2 == 1, sensor.isGasMeasured());
+    }
+
+    CHECK(warmup.isSettled());
+
+    sensor.skipGasMeasurement(true);
+    CHECK(warmup.performReading());
+    CHECK(!sensor.isGasMeasured());
+    CHECK(warmup.isSettled());
+}
+
+static void testTimeToStable() {
+    BME680Simulator simulator;
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680GasWarmup warmup(sensor, 320, 150);
+
+    CHECK(sensor.begin());
+    warmup.setWarmup(30, 4, 0);
+
+    /* Without a sampling interval yet the measurement duration is the estimate */
+    CHECK_EQUAL(4U * sensor.getProfileDuration(), warmup.getTimeToStable());
+
+    CHECK(warmup.performReading());
+    mbed_mock::advanceUs(1000000);
+    CHECK(warmup.performReading());
+
+    /* Two missing readings at the interval of one second plus the reading */
+    uint32_t interval = 1000 + sensor.getProfileDuration();
+
+    CHECK_NEAR(2 * interval, warmup.getTimeToStable(), 2 * 10);
+
+    warmup.reset();
+    CHECK(!warmup.isSettled());
+}
+
+static void testWithoutSensor() {
+    BME680 sensor(0x77 << 1, I2C_SDA, I2C_SCL);
+    BME680GasWarmup warmup(sensor, 320, 150);
+
+    CHECK(!warmup.performReading());
+}
+
+int main() {
+    RUN(testSettle);
+    RUN(testRetries);
+    RUN(testGasDecimation);
+    RUN(testTimeToStable);
+    RUN(testWithoutSensor);
+
+    return TEST_RESULT;
+}